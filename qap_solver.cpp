@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 #include <algorithm>
 #include <random>
@@ -9,16 +10,60 @@
 #include <deque>
 #include <climits>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <unordered_set>
+#include <unordered_map>
+#include <map>
+#include <set>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <array>
+#include <tuple>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 using namespace std;
 
+using Matrix = vector<vector<int>>;
+
+// Distance-matrix symmetries kept per instance; grid-like buildings have a handful, fully
+// uniform ones have n! and only this many are used
+const size_t AUTOMORPHISM_LIMIT = 256;
+
+// Data derived from a (distance, flow) pair, computed once by derive_problem and shared read-only
+struct ProblemDerived {
+    bool symmetric = false; //both matrices are symmetric, which halves the work of a swap delta
+    bool sparse_flow = false; //at most half of the flows are non-zero, so costs are summed over flow_rows
+    vector<vector<pair<int, int>>> flow_rows; //(facility, flow) for the non-zero entries of each flow row
+    bool narrow_rows = false; //every row sum of flow * distance fits in an int, so batch kernels accumulate rows in 32 bits
+    vector<vector<int>> automorphisms; //non-identity location permutations that preserve every distance, at most AUTOMORPHISM_LIMIT
+};
+
 struct Problem {
     int n;
-    vector<vector<int>> distance; //the distance matrix, distances between the factories 
-    vector<vector<int>> flow; //the amount of flow between facilities 
-    Problem(int size) : n(size) { //part after the colon is a member initializer, we initialize n to size 
-        distance.resize(n, vector<int>(n)); //resize to size n*n
-        flow.resize(n, vector<int>(n)); //same thing here 
-    }
+    // the matrices live in shared immutable storage, so solves of instances that share a
+    // distance or flow matrix (e.g. through the instance cache) also share its memory
+    shared_ptr<const Matrix> distance_data;
+    shared_ptr<const Matrix> flow_data;
+    shared_ptr<const ProblemDerived> derived;
+    const Matrix& distance; //the distance matrix, distances between the factories 
+    const Matrix& flow; //the amount of flow between facilities 
+    Problem(shared_ptr<const Matrix> d, shared_ptr<const Matrix> f, shared_ptr<const ProblemDerived> derived_data)
+        : n(static_cast<int>(d->size())), distance_data(move(d)), flow_data(move(f)), derived(move(derived_data)),
+          distance(*distance_data), flow(*flow_data) {}
+    Problem(const Problem& other)
+        : n(other.n), distance_data(other.distance_data), flow_data(other.flow_data), derived(other.derived),
+          distance(*distance_data), flow(*flow_data) {}
 };
 
 struct Wolf {
@@ -40,13 +85,673 @@ struct Config {
     // additional controls
     int ts_every = 1; // apply Tabu Search every K iterations (1 = every iteration)
     double jitter = 0.0; // add small uniform noise in [-jitter, jitter] before LVP decode
+    int elite_size = 0; // number of distinct solutions kept in the elite archive (0 = no archive)
+    int elite_distance = 3; // solutions differing in fewer facilities than this compete for one archive slot
+    int elite_restart = 0; // restart Tabu Search from an elite solution every this many iterations without improvement (0 = never)
+    int top_k = 0; // report the K best distinct layouts seen during the run (0 = off)
+    int pr_every = 0; // run path relinking between elite solutions every K iterations (0 = off)
+    int pr_pairs = 2; // elite solutions relinked with alpha in each path relinking phase
+    int pr_ts_iterations = 20; // Tabu Search iterations launched from each promising intermediate
+    int solution_tabu = 0; // Tabu Search may not return to any of its last K solutions, found by zobrist hash (0 = off)
+    double freq_penalty = 0.0; // weight of the long-term frequency penalty while Tabu Search diversifies (0 = off)
+    string polish = "off"; // swap descent on every decoded wolf: off, first (first improvement) or best (steepest per facility)
+    int polish_looks = 0; // stop polishing a wolf after this many facility scans per facility (0 = at the local optimum)
+    int opposition = 0; // opposition-based initialization, and quasi-opposition jumps after this many iterations without improvement (0 = off)
+    string a_schedule = "linear"; // how the GWO coefficient a falls from 2 to 0: linear or quadratic (explores longer)
+    string coefficients = "uniform"; // source of the r1 / r2 coefficients: uniform random, or the logistic or tent chaotic map
+    string steps = "gwo"; // gwo: plain position update; levy: add a heavy-tailed Levy flight step relative to alpha
+    long long target = LLONG_MIN; // stop the search once alpha costs at most this much (LLONG_MIN = no target)
+    bool lamarckian = false; // --learning lamarckian: refined layouts are encoded back into positions; baldwinian (false): positions keep their own layout
+    uint64_t seed = 0; // random seed (0 = seed from random_device)
+    double time_limit = 0.0; // stop the search after this many seconds (0 = no limit)
+    int priority = 0; // server / batch: solves with higher priority are scheduled first
+    double deadline = 0.0; // answer within this many seconds of the request, stopping the search if needed (0 = none)
+    int exact_max_n = 10; // solve instances up to this size exactly instead of running GWO + TS (0 = never)
+    long long exact_nodes = 300000; // branch and bound gives up and falls back to GWO + TS after this many nodes
+    int clusters = 0; // solve location clusters separately, then stitch and refine (0 = off, -1 = detect the count)
+    int multilevel = 0; // coarsen larger instances to at most this many facilities, solve, then refine level by level (0 = off)
+    string preset; // named parameter set, resolved by instance size once the instance is loaded (see PRESETS)
+    bool auto_budget = false; // size pack, iterations and Tabu Search from n, density and the time limit, using measured kernel speeds
+    // server / client mode
+    string serve_socket; // serve solve requests on this unix domain socket
+    string client_socket; // send the instance to the server listening on this socket
+    bool shutdown_server = false; // client: ask the server to exit instead of solving
+    string batch_file; // solve every request line of this file, sharing one instance cache
+    int workers = 4; // persistent worker threads in server and batch mode
+    double slice_ms = 5.0; // server: a solve gives up its worker after this much work so others get a turn
+    int threads = 1; // threads used inside one search (pack evaluation, Tabu Search scans)
+    int cache_size = 64; // instances kept by the server / batch instance cache
+    vector<pair<string, string>> explicit_options; // options given on the command line, in order
+    set<string> pinned; // options set explicitly (command line, config file, request), which presets leave alone
+};
+
+// Measured speed of the two kernels the search spends its time in, used by --auto
+struct KernelSpeed {
+    double delta_seconds = 0.0; //one O(n) swap delta
+    double scan_seconds = 0.0; //one single-threaded Tabu Search iteration: scan the swap deltas, then update them
+    double rebuild_seconds = 0.0; //computing every swap delta from scratch, paid by TS calls far from the last one
+    double cost_seconds = 0.0; //one full cost evaluation
+};
+
+// One parameter set of a named preset; the first entry of the preset whose max_n covers the
+// instance is used
+struct PresetEntry {
+    string name;
+    int max_n;
+    vector<pair<string, string>> options;
+};
+
+const vector<PresetEntry> PRESETS = {
+    {"fast", 100, {{"--pack-size", "20"}, {"--max-iterations", "50"}, {"--ts-iterations", "30"}}},
+    {"fast", 500, {{"--pack-size", "15"}, {"--max-iterations", "20"}, {"--ts-iterations", "10"}, {"--pr-every", "0"}}},
+    {"fast", INT_MAX, {{"--multilevel", "64"}, {"--ts-iterations", "20"}, {"--pack-size", "15"}, {"--max-iterations", "20"}}},
+    {"balanced", 100, {}},
+    {"balanced", 500, {{"--pack-size", "20"}, {"--max-iterations", "50"}, {"--ts-iterations", "30"}}},
+    {"balanced", INT_MAX, {{"--multilevel", "128"}}},
+    {"thorough", 100, {{"--pack-size", "60"}, {"--max-iterations", "500"}, {"--ts-iterations", "100"}, {"--tabu-tenure", "20"},
+                       {"--elite-size", "20"}, {"--elite-restart", "10"}, {"--pr-every", "10"}, {"--pr-pairs", "4"}, {"--freq-penalty", "0.5"},
+                       {"--exact-nodes", "2000000"}}},
+    {"thorough", 500, {{"--pack-size", "40"}, {"--max-iterations", "200"}, {"--ts-iterations", "100"}, {"--tabu-tenure", "20"},
+                       {"--elite-size", "10"}, {"--elite-restart", "10"}, {"--pr-every", "10"}, {"--freq-penalty", "0.5"}}},
+    {"thorough", INT_MAX, {{"--multilevel", "256"}, {"--ts-iterations", "100"}, {"--tabu-tenure", "20"}}},
+    {"large-n", 100, {{"--pack-size", "20"}, {"--max-iterations", "50"}}},
+    {"large-n", 500, {{"--clusters", "auto"}, {"--multilevel", "64"}, {"--pack-size", "15"}, {"--max-iterations", "30"}, {"--ts-iterations", "20"}}},
+    {"large-n", INT_MAX, {{"--clusters", "auto"}, {"--multilevel", "64"}, {"--ts-iterations", "20"}}},
+};
+
+// Persistent helper threads for the data-parallel loops of one search
+struct ThreadPool {
+    int threads;
+    vector<thread> helpers;
+    mutex lock;
+    condition_variable wake, finished;
+    const function<void(int)>* job = nullptr;
+    long long generation = 0;
+    int running = 0;
+    bool stopping = false;
+    ThreadPool(int count);
+    ~ThreadPool();
+    void run(const function<void(int worker)>& body); //body(w) for every w in [0, threads); the caller runs w = 0
+};
+
+// Permutations evaluated together by evaluate_block; each flow row is loaded once per block
+const int BATCH_BLOCK = 16;
+
+// Smallest n for which a Tabu Search neighborhood scan is worth splitting across threads
+const int PARALLEL_SCAN_MIN_N = 32;
+
+// Largest n solved exactly by enumerating every permutation; branch and bound takes over above it
+const int ENUMERATION_MAX_N = 9;
+
+// Largest level of a multilevel solve that is refined by full Tabu Search; bigger levels only
+// try swaps between nearby locations
+const int MULTILEVEL_TS_MAX_N = 256;
+
+// Nearest locations tried for each facility by the multilevel refinement
+const int MULTILEVEL_NEIGHBORS = 8;
+
+// Stability index and scale of the Levy flight steps of --steps levy
+const double LEVY_BETA = 1.5;
+const double LEVY_SCALE = 0.01;
+
+// Outcome of the exact solver for small instances
+struct ExactResult {
+    bool optimal = false; //false when branch and bound ran out of nodes before covering every layout
+    vector<int> permutation;
+    long long cost = LLONG_MAX;
+    long long nodes = 0; //permutations enumerated or branch-and-bound nodes visited
+    string method; //"enumeration" or "branch and bound"
+    double seconds = 0.0;
+};
+
+// A candidate Tabu Search move and its (possibly penalized) score
+struct MoveChoice {
+    double score = HUGE_VAL;
+    long long cost = LLONG_MAX;
+    int i = -1, j = -1;
+};
+
+// Open-addressing set of recently visited solutions, keyed by zobrist hash with linear probing.
+// A solution can be in the window more than once, so each slot counts its occurrences and keeps
+// the iteration it was last visited in; a slot with count 0 is empty.
+struct SolutionSet {
+    struct Slot {
+        uint64_t key = 0;
+        int count = 0;
+        int visited = 0;
+    };
+    vector<Slot> slots;
+    size_t mask;
+    SolutionSet(int capacity); //room for capacity solutions at load factor <= 1/2
+    const Slot* find(uint64_t key) const; //nullptr if key is not in the set
+    void add(uint64_t key, int iteration);
+    void remove(uint64_t key); //drop one occurrence; empty slots are closed by shifting entries back
+};
+
+// Memory shared by every Tabu Search call within one run
+struct TabuMemory {
+    long long global_best = LLONG_MAX; //best cost seen by any TS call, used by the aspiration criterion
+    int n;
+    vector<long long> frequency; //frequency[i * n + loc] = TS iterations facility i spent at location loc
+    long long recorded = 0; //number of TS iterations counted in frequency
+    double penalty; //weight of the frequency penalty during diversification phases
+    // swap deltas of the best layout of the last TS call, usually the next call's start (alpha);
+    // the next call replays the few swaps that separate the two instead of rebuilding in O(n^3)
+    vector<long long> deltas; //deltas[i * n + j], i < j: cost change of swapping facilities i and j in delta_layout
+    vector<int> delta_layout; //empty until the first TS call
+    int solution_window; //a TS call may not return to any of its last solution_window solutions (0 = off)
+    // cycling statistics of the solution tabu
+    long long window_moves = 0; //TS moves made with the solution tabu on
+    long long cycles_blocked = 0; //moves whose best choice would have returned to a recent solution
+    long long cycle_length_sum = 0; //iterations since that solution was visited, summed over blocked moves
+    int longest_cycle = 0;
+    TabuMemory(int size, double weight, int window = 0)
+        : n(size), frequency(static_cast<size_t>(size) * size, 0), penalty(weight), solution_window(window) {}
+};
+
+// One Tabu Search call, made a move at a time so that a server slice can end between two moves
+// and the next slice carries on where it stopped; apply_tabu_search runs it to the end at once
+struct TabuRun {
+    const Problem& problem;
+    Wolf& wolf; //the start, replaced by the best solution when the run finishes
+    TabuMemory& memory;
+    int ts_iterations;
+    int tabu_tenure;
+    int iter = 0; //moves made so far
+    bool stuck = false; //every move was tabu without aspiration
+    deque<pair<int, int>> tabu_list;
+    vector<int> tabu_count; //tabu_count[i * n + j] = occurrences of move (i, j) in tabu_list, so checking a move is O(1)
+    vector<int> current_solution, best_solution;
+    long long current_cost, best_cost;
+    int since_improvement = 0;
+    long long evaluated = 0;
+    vector<long long> best_deltas; //deltas of best_solution, handed to the next call
+    // solution tabu: the hashes of the last solution_window solutions; a neighbor's hash follows
+    // from the current one in O(1), and is only looked up for moves that would be chosen otherwise
+    SolutionSet visited; //the newest solution is added before the oldest is dropped
+    deque<uint64_t> recent;
+    vector<uint64_t> own_keys; //own_keys[f] = zobrist key of facility f at its current location
+    uint64_t current_hash = 0;
+    vector<MoveChoice> partial, partial_blocked; //best move, and best move skipped for returning to a recent solution, of each worker
+    TabuRun(const Problem& p, Wolf& start, int iterations, int tenure, TabuMemory& m, ThreadPool* pool);
+    bool advance(ThreadPool* pool); //make one move, false once the run is over
+    long long finish(); //hand the best solution to wolf and its deltas to memory, returns the number of moves evaluated
+};
+
+// Path relinking from a source layout towards a target, a swap at a time like TabuRun
+struct RelinkRun {
+    const Problem& problem;
+    vector<double> position; //the source's position, given to every kept intermediate
+    vector<int> target;
+    vector<int> current;
+    vector<int> facility_at; //inverse of current: which facility sits at each location
+    long long cost;
+    int keep;
+    vector<Wolf> best; //the keep cheapest intermediates, cheapest first
+    RelinkRun(const Problem& p, const Wolf& source, const vector<int>& target_layout, int count);
+    bool advance(); //make one swap towards target, false once it is reached
+};
+
+// One distinct solution remembered by the elite archive
+struct EliteEntry {
+    vector<int> permutation;
+    vector<double> position; //continuous position, needed when the entry is promoted to a leader
+    long long cost;
+    uint64_t hash; //zobrist hash of the permutation
+};
+
+// Bounded archive of good solutions, sorted by cost and deduplicated by permutation hash
+struct EliteArchive {
+    int capacity;
+    int min_distance;
+    const vector<vector<int>>* automorphisms = nullptr; //layouts equivalent under these share one entry
+    vector<EliteEntry> entries;
+    unordered_set<uint64_t> hashes;
+    EliteArchive(int cap, int dist) : capacity(cap), min_distance(dist) {}
+};
+
+// The K cheapest distinct solutions seen so far, kept as a max-heap on (cost, hash)
+// so that rejecting a candidate is a single comparison against the current worst
+struct TopKCollector {
+    int k;
+    vector<pair<long long, uint64_t>> heap;
+    unordered_map<uint64_t, vector<int>> solutions; //permutations of the heap members, by layout hash
+    const vector<vector<int>>* automorphisms = nullptr; //layouts equivalent under these are reported once
+    TopKCollector(int size) : k(size) {}
+};
+
+// Progress of a search: emitted after every iteration, with the permutation when the best improved
+struct SearchEvent {
+    bool improved = false;
+    int iteration = 0;
+    long long cost = 0;
+    vector<int> permutation;
+    double seconds = 0.0;
+    long long evaluations = 0; //full cost evaluations plus swap deltas so far
+};
+
+// Lock-free single-producer single-consumer ring buffer; head and tail sit on separate
+// cache lines so producer and consumer do not invalidate each other's line on every push
+template <typename T>
+struct SpscQueue {
+    vector<T> slots;
+    size_t mask;
+    alignas(64) atomic<size_t> head{0}; //next slot to read, written by the consumer
+    alignas(64) atomic<size_t> tail{0}; //next slot to write, written by the producer
+    SpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+    bool try_push(T& item) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = move(item);
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+    bool try_pop(T& item) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire)) return false;
+        item = move(slots[h & mask]);
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+};
+
+// Hands search events to a consumer thread so printing them never blocks the search. Only direct
+// runs print progress this way; the server collects a slice's improvements in the task's outbox
+// and the accept loop sends them. If the queue is full the newest event waits in `pending` and
+// supersedes older waiting ones, so the consumer always ends up seeing the final best.
+struct EventStream {
+    SpscQueue<SearchEvent> queue;
+    SearchEvent pending;
+    bool has_pending = false;
+    atomic<bool> closed{false};
+    thread consumer;
+    EventStream(function<void(const SearchEvent&)> handle, size_t capacity = 1024);
+    ~EventStream() { close(); }
+    void publish(SearchEvent event); //never blocks
+    void close(); //deliver everything published so far and stop the consumer
+};
+
+struct GwoSearch;
+
+// Where an iteration stands after its pack was evaluated. Tabu Search and path relinking are
+// resumable, so a server slice can end between two of their moves and the next slice resumes
+// the iteration there instead of it having to run whole
+enum class StepPhase { Tabu, Relink, Starts, Tail };
+
+struct StepState {
+    bool active = false; //an iteration was started by GwoEngine::step and has not finished yet
+    StepPhase phase = StepPhase::Tabu;
+    int best_index = 0; //this iteration's best wolf, replaced by alpha at the end
+    bool improved = false; //alpha improved during this iteration
+    bool restart = false; //Tabu Search runs on `restart_wolf`, an elite solution, instead of alpha
+    long long before = 0; //alpha's cost before its Tabu Search
+    Wolf restart_wolf{0};
+    unique_ptr<TabuRun> tabu; //Tabu Search in progress
+    vector<Wolf> guides; //elite solutions relinked with alpha this iteration
+    size_t guide = 0; //the guide being relinked
+    unique_ptr<RelinkRun> relink; //relinking path in progress
+    bool relink_back = false; //the path in progress runs from the guide back to alpha
+    vector<Wolf> starts; //the intermediates of the current guide's two paths
+    size_t next_start = 0;
+    chrono::steady_clock::duration work{0}; //time spent on this iteration before the current slice
+};
+
+// One pre-instantiated GwoEngine, looked up in engine_registry by the policy names in the config
+struct GwoEngineEntry {
+    void (*init)(GwoSearch& search); //random pack, first evaluation and leaders
+    bool (*step)(GwoSearch& search); //start an iteration, false once the search is finished
+};
+
+// State of one GWO + Tabu Search run, advanced one iteration at a time by search_step
+struct GwoSearch {
+    const Problem& problem;
+    Config config;
+    mt19937 gen;
+    vector<Wolf> wolves;
+    Wolf alpha, beta, delta;
+    EliteArchive archive;
+    TopKCollector top;
+    TabuMemory tabu_memory;
+    unique_ptr<ThreadPool> pool; // only created when config.threads > 1
+    vector<uint64_t> hashes; // permutation hash of each wolf, the tie-break for leader selection
+    int iteration = 0;
+    int stagnation = 0; // iterations since alpha last improved
+    double chaos = 0.0; // state of the chaotic coefficient map, seeded on first use
+    const GwoEngineEntry* engine = nullptr; // policy combination the config selects, resolved by init_search
+    size_t restart_index = 0; // next elite entry to restart Tabu Search from
+    int next_restart = 0; // stagnation at which the next elite restart is due; alpha gets Tabu Search in between
+    chrono::steady_clock::time_point start;
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max(); // stop here even if iterations remain
+    chrono::steady_clock::duration longest_step{0}; // longest iteration so far, or init_search before the first
+    StepState step; // the iteration in progress
+    long long evaluations = 0; // full cost evaluations plus swap deltas so far
+    function<void(const SearchEvent& event)> progress; // called after every iteration
+    GwoSearch(const Problem& p, const Config& c);
+};
+
+// Policies of the search. GwoEngine<Decoder, Update, LocalSearch, Stop> composes one of each at
+// compile time; engine_registry holds every combination, so the choice is made once per run and
+// the loops over wolves and coordinates have no runtime dispatch. Each policy's name is the value
+// of its command line option.
+
+// positions become layouts by Largest Value Priority; encode_position is its inverse, used by
+// Lamarckian learning and the opposition steps
+struct LvpDecoder {
+    static constexpr const char* name = "lvp";
+    static vector<int> decode(const vector<double>& position);
+};
+
+// Update policies: the GWO position update with one schedule for a, one source of the r1 / r2
+// coefficients and one kind of step
+
+// a falls linearly from 2 to 0 over the run
+struct LinearSchedule {
+    static constexpr const char* name = "linear";
+    static double a(int iteration, int max_iterations) { return 2.0 - 2.0 * iteration / max_iterations; }
+};
+
+// a stays near 2 for longer, giving more exploration before the pack converges
+struct QuadraticSchedule {
+    static constexpr const char* name = "quadratic";
+    static double a(int iteration, int max_iterations) {
+        double t = static_cast<double>(iteration) / max_iterations;
+        return 2.0 * (1.0 - t * t);
+    }
+};
+
+// r1 / r2 drawn uniformly from [-1, 1]
+struct UniformCoefficients {
+    static constexpr const char* name = "uniform";
+    uniform_real_distribution<> dis{-1.0, 1.0};
+    explicit UniformCoefficients(GwoSearch&) {}
+    double operator()(mt19937& gen) { return dis(gen); }
+};
+
+// r1 / r2 from the logistic map x -> 4x(1 - x), scaled to [-1, 1]; the state is reseeded if
+// rounding lands it on a fixed point
+struct LogisticCoefficients {
+    static constexpr const char* name = "logistic";
+    double& x;
+    explicit LogisticCoefficients(GwoSearch& search) : x(search.chaos) {}
+    double operator()(mt19937& gen) {
+        if (x <= 0.0 || x >= 1.0 || x == 0.75) x = uniform_real_distribution<>(0.0, 1.0)(gen);
+        x = 4.0 * x * (1.0 - x);
+        return 2.0 * x - 1.0;
+    }
+};
+
+// r1 / r2 from the skewed tent map with peak 0.7, scaled to [-1, 1]
+struct TentCoefficients {
+    static constexpr const char* name = "tent";
+    double& x;
+    explicit TentCoefficients(GwoSearch& search) : x(search.chaos) {}
+    double operator()(mt19937& gen) {
+        if (x <= 0.0 || x >= 1.0) x = uniform_real_distribution<>(0.0, 1.0)(gen);
+        x = x < 0.7 ? x / 0.7 : (1.0 - x) / 0.3;
+        return 2.0 * x - 1.0;
+    }
+};
+
+// the plain GWO update
+struct PlainSteps {
+    static constexpr const char* name = "gwo";
+    static constexpr bool active = false;
+    double operator()(mt19937&) { return 0.0; }
+};
+
+// Levy flight step lengths by Mantegna's algorithm
+struct LevySteps {
+    static constexpr const char* name = "levy";
+    static constexpr bool active = true;
+    normal_distribution<> u, v{0.0, 1.0};
+    LevySteps()
+        : u(0.0, pow(tgamma(1.0 + LEVY_BETA) * sin(M_PI * LEVY_BETA / 2.0) /
+                     (tgamma((1.0 + LEVY_BETA) / 2.0) * LEVY_BETA * pow(2.0, (LEVY_BETA - 1.0) / 2.0)), 1.0 / LEVY_BETA)) {}
+    double operator()(mt19937& gen) { return u(gen) / pow(abs(v(gen)), 1.0 / LEVY_BETA); }
+};
+
+template <typename Schedule, typename Coefficients, typename Steps>
+struct GwoUpdate {
+    static string name() { return string(Schedule::name) + "/" + Coefficients::name + "/" + Steps::name; }
+    static void apply(GwoSearch& search); //move every wolf towards alpha, beta and delta
+};
+
+// Local search policies, run on every wolf right after it is decoded (--polish)
+struct NoPolish {
+    static constexpr const char* name = "off";
+    static constexpr bool active = false;
+    static long long apply(const Problem&, Wolf&, int) { return 0; }
+};
+
+struct FirstImprovementPolish {
+    static constexpr const char* name = "first";
+    static constexpr bool active = true;
+    static long long apply(const Problem& problem, Wolf& wolf, int looks);
+};
+
+struct BestImprovementPolish {
+    static constexpr const char* name = "best";
+    static constexpr bool active = true;
+    static long long apply(const Problem& problem, Wolf& wolf, int looks);
+};
+
+// Stop policies, asked before every iteration
+// iteration limit, time limit and deadline
+struct BudgetStop {
+    static constexpr const char* name = "budget";
+    static bool proceed(const GwoSearch& search);
+};
+
+// the budget, or as soon as alpha reaches --target
+struct TargetStop {
+    static constexpr const char* name = "target";
+    static bool proceed(const GwoSearch& search);
+};
+
+template <typename Decoder, typename Update, typename LocalSearch, typename Stop>
+struct GwoEngine {
+    static string name() { return string(Decoder::name) + "/" + Update::name() + "/" + LocalSearch::name + "/" + Stop::name; }
+    static void init(GwoSearch& search);
+    static bool step(GwoSearch& search);
+};
+
+template <typename... Ts>
+struct TypeList {};
+
+// Calls visitor.apply<T1, ..., Tk>() for every choice of one type from each list
+template <typename Chosen, typename... Lists>
+struct Combinations;
+
+template <typename... Chosen>
+struct Combinations<TypeList<Chosen...>> {
+    template <typename Visitor> static void visit(Visitor& visitor) { visitor.template apply<Chosen...>(); }
+};
+
+template <typename... Chosen, typename... Options, typename... Rest>
+struct Combinations<TypeList<Chosen...>, TypeList<Options...>, Rest...> {
+    template <typename Visitor> static void visit(Visitor& visitor) {
+        (Combinations<TypeList<Chosen..., Options>, Rest...>::visit(visitor), ...);
+    }
+};
+
+// Shared pieces of cached problems, found by content hash; a problem's derived data is only
+// reused together with the exact matrices it was computed from
+struct CachedDerived {
+    weak_ptr<const Matrix> distance;
+    weak_ptr<const Matrix> flow;
+    weak_ptr<const ProblemDerived> derived;
+};
+
+// A cached problem with the text it was parsed from; the text is compared on every hit, since
+// two different instances can share a 64-bit hash
+struct CachedProblem {
+    string text;
+    shared_ptr<const Problem> problem;
+};
+
+// Instances loaded in server and batch mode. Problems are keyed by a hash of their text; their
+// matrices and derived data are deduplicated by content, so requests that reuse a distance matrix
+// with different flows store and preprocess it once. Only the problems are owned by the cache,
+// the shared pieces live as long as some cached or running problem uses them.
+struct InstanceCache {
+    mutex lock;
+    size_t capacity = 64; //problems kept, the oldest is evicted first
+    unordered_map<uint64_t, CachedProblem> problems;
+    deque<uint64_t> order; //insertion order of problems
+    unordered_map<uint64_t, weak_ptr<const Matrix>> matrices;
+    unordered_map<uint64_t, CachedDerived> derived;
+    long long text_hits = 0, matrix_hits = 0, derived_hits = 0, loads = 0;
+};
+
+// A client connection of the solve server. Only the accept loop touches the socket, and never
+// blocks on it: requests are buffered until their whole frame has arrived, and answers wait in
+// `outgoing` until the client takes them, so a slow or stalled client never holds up the accept
+// loop or a worker.
+struct Connection {
+    int fd;
+    string incoming; //bytes received but not yet taken as a request, accept loop only
+    bool busy = false; //a request from this connection is queued or running, accept loop only
+    string outgoing; //encoded frames not yet sent, guarded by ServerState::lock
+    bool closed = false; //the client went away, guarded by ServerState::lock
+};
+
+// One solve request in server mode. Workers advance it a time slice at a time and put it back
+// at the end of the run queue, so many concurrent solves share a few threads round-robin
+struct SolveTask {
+    shared_ptr<Connection> connection; //where the request came from and the answers go
+    map<string, string> fields;
+    Config config; //server defaults with the request's options applied
+    chrono::steady_clock::time_point deadline; //when the answer is due, time_point::max() if never
+    shared_ptr<const Problem> problem; //keeps the cached instance alive while the search uses it
+    unique_ptr<GwoSearch> search; //created by the task's first slice unless the instance was solved exactly
+    ExactResult exact;
+    bool cached = false;
+    vector<string> outbox; //improvement frames produced during the current slice
+};
+
+// How the solves that carried a deadline turned out
+struct DeadlineStats {
+    mutex lock;
+    long long solves = 0;
+    long long missed = 0;
+    double worst_lateness = 0.0; //seconds
+};
+
+// Run queue order: higher priority first, then earliest deadline, then least recently run
+using TaskKey = tuple<int, chrono::steady_clock::time_point, long long>;
+
+// Shared state of the solve server. The accept loop polls the connections, queues their requests
+// in `runnable` and sends what workers posted; workers hand connections back through `returned`
+// and the wake pipe.
+struct ServerState {
+    int listen_fd = -1;
+    int wake_pipe[2] = {-1, -1};
+    mutex lock;
+    condition_variable ready;
+    map<TaskKey, unique_ptr<SolveTask>> runnable;
+    long long next_sequence = 0; //requeued tasks get a fresh sequence number, giving round-robin among equals
+    int busy = 0; //workers currently running a slice
+    int lent = 0; //idle workers whose share of the CPU a boosted slice is using
+    vector<int> returned; //connections whose request finished
+    map<int, shared_ptr<Connection>> connections; //open connections by fd, the map itself is only used by the accept loop
+    atomic<bool> stopping{false};
+    InstanceCache cache;
+    DeadlineStats deadlines;
 };
 
 // Function declarations
 Problem load_problem(const string& filename); //function to load the problem from a file
+Problem parse_problem(istream& in); //read an instance in the n / distance / flow format
 long long calculate_cost(const Problem& problem, const vector<int>& permutation); //function to calculate the cost of a given permutation
+shared_ptr<const ProblemDerived> derive_problem(const Matrix& distance, const Matrix& flow); //symmetry, sparse flow rows and automorphisms
+Problem make_problem(Matrix distance, Matrix flow); //wrap freshly built matrices into a problem with its derived data
+void read_matrices(istream& in, Matrix& distance, Matrix& flow); //read the n / distance / flow format
+long long compute_swap_delta(const Problem& problem, const vector<int>& permutation, int r, int s); //O(n) cost change of swapping the locations of facilities r and s
+void evaluate_block(const Problem& problem, const vector<int>* const* permutations, int count, long long* costs); //costs of up to BATCH_BLOCK permutations at once
+void evaluate_batch(const Problem& problem, const vector<const vector<int>*>& permutations, vector<long long>& costs, ThreadPool* pool = nullptr); //costs of many permutations
+void evaluate_batch(const Problem& problem, const vector<vector<int>>& permutations, vector<long long>& costs, ThreadPool* pool = nullptr);
+ExactResult enumerate_layouts(const Problem& problem); //every permutation in Heap's order, each costed with one swap delta
+ExactResult branch_and_bound(const Problem& problem, long long node_budget, chrono::steady_clock::time_point stop); //depth-first search with a Gilmore-Lawler style bound
+bool solve_exactly(const Problem& problem, const Config& config, ExactResult& result, chrono::steady_clock::time_point deadline); //exact answer for small instances, false if not attempted or out of budget
+void print_exact(const ExactResult& result); //final report of an exact solve
+void print_layout(const vector<int>& permutation, long long cost); //"FINAL RESULTS" header, cost and assignment
+Wolf solve_standalone(const Problem& problem, const Config& config); //exact solver when possible, otherwise a silent GWO + TS run
+vector<int> cluster_locations(const Problem& problem, int clusters); //location -> cluster, cutting the longest distance MST edges; -1 picks the widest gap
+vector<int> group_facilities(const Problem& problem, const vector<int>& sizes); //facility -> group, grown by flow to the given group sizes
+bool solve_decomposed(const Problem& problem, const Config& config, Wolf& result, string& summary); //solve clusters in parallel, stitch, refine; false without cluster structure
+vector<int> match_pairs(const Matrix& weight, bool heaviest, int& count); //node -> pair, greedily matching the heaviest (or lightest) edges; count receives the number of pairs
+Problem coarsen_problem(const Problem& problem, const vector<int>& facility_pair, const vector<int>& location_pair, int count); //flows summed and distances averaged over merged nodes
+long long refine_nearby(const Problem& problem, Wolf& wolf, int neighbors); //swap descent restricted to each facility's nearest locations, returns the improvement
+bool solve_multilevel(const Problem& problem, const Config& config, Wolf& result, string& summary); //coarsen, solve the coarsest level, uncoarsen with refinement; false if n is already small
 vector<int> lvp_decode(const vector<double>& position); //do the lvp decode, returns a permutation 
-void apply_tabu_search(const Problem& problem, Wolf& wolf, int ts_iterations, int tabu_tenure); //apply tabu search to a wolf
+void encode_position(Wolf& wolf); //rearrange wolf.position so that it decodes to wolf.permutation
+void learn(const Config& config, Wolf& wolf); //after local search: encode the refined layout back in Lamarckian mode
+vector<Wolf> path_relink(const Problem& problem, const Wolf& source, const vector<int>& target, int keep); //best intermediates on the swap path from source to target
+long long polish_layout(const Problem& problem, Wolf& wolf, bool first_improvement, int looks); //swap descent with don't-look bits, at most looks * n facility scans (0 = no limit); returns the number of swaps evaluated
+long long apply_tabu_search(const Problem& problem, Wolf& wolf, int ts_iterations, int tabu_tenure, TabuMemory& memory, ThreadPool* pool = nullptr); //apply tabu search to a wolf, returns the number of moves evaluated
+void build_deltas(const Problem& problem, TabuMemory& memory, const vector<int>& permutation, ThreadPool* pool); //every swap delta of permutation from scratch, O(n^3)
+void update_deltas(const Problem& problem, TabuMemory& memory, int r, int s, ThreadPool* pool); //swap r and s in memory.delta_layout and update the deltas in O(n^2)
+void sync_deltas(const Problem& problem, TabuMemory& memory, const vector<int>& permutation, ThreadPool* pool); //bring the deltas to permutation by replaying swaps, or rebuild if it is far away
+bool better_move(const MoveChoice& a, const MoveChoice& b); //order moves by score, then by (i, j)
+uint64_t zobrist_key(int facility, int location); //random 64-bit key for assigning facility to location
+uint64_t hash_permutation(const vector<int>& permutation); //xor of the zobrist keys of all assignments
+vector<vector<int>> find_automorphisms(const Matrix& distance); //location permutations that preserve the distance matrix
+vector<int> canonical_layout(const vector<int>& permutation, const vector<vector<int>>& automorphisms); //smallest layout equivalent to permutation
+uint64_t layout_hash(const vector<int>& permutation, const vector<vector<int>>* automorphisms); //hash shared by all equivalent layouts
+bool elite_insert(EliteArchive& archive, const Wolf& wolf); //offer a solution to the archive, returns true if it was kept
+Wolf elite_wolf(const EliteEntry& entry); //rebuild a wolf from an archive entry
+void topk_offer(TopKCollector& top, const vector<int>& permutation, long long cost); //offer a solution to the top-K heap
+void print_top_k(const TopKCollector& top); //print the collected layouts, best first, with pairwise differences
+string engine_name(const Config& config); //registry key of the policies config selects, e.g. "lvp/linear/uniform/gwo/off/budget"
+const map<string, GwoEngineEntry>& engine_registry(); //every policy combination, instantiated once
+void init_search(GwoSearch& search); //random initial pack and leaders
+void seed_pack(GwoSearch& search); //random initial positions
+void init_leaders(GwoSearch& search, const array<int, 3>& best); //leaders and archive from the first evaluation
+void opposition_init(GwoSearch& search); //keep the better half of the random pack and its opposite points
+bool quasi_opposition_jump(GwoSearch& search); //move wolves to quasi-opposite points that decode to cheaper layouts, true if alpha improved
+template <typename Decoder, typename LocalSearch> array<int, 3> evaluate_pack(GwoSearch& search); //decode and evaluate every wolf, returns the indices of the three best
+bool search_step(GwoSearch& search); //run one GWO iteration, returns false once the search is finished
+bool search_until(GwoSearch& search, chrono::steady_clock::time_point until, const function<bool()>& interrupt); //run iterations until `until` or interrupt(), possibly stopping within one; false once the search is finished
+void finish_step(GwoSearch& search, const array<int, 3>& best); //leaders and archive after the pack was evaluated; sets up the rest of the iteration
+bool resume_step(GwoSearch& search, chrono::steady_clock::time_point until, const function<bool()>& interrupt); //Tabu Search, path relinking and the iteration's end; false if it paused first
+double search_seconds(const GwoSearch& search); //seconds since init_search
+void print_results(const GwoSearch& search); //print the final report
+uint64_t hash_text(const string& text); //FNV-1a hash, used as instance cache key
+uint64_t hash_matrix(const Matrix& matrix); //FNV-1a hash of the matrix entries
+shared_ptr<const Problem> cache_instance(InstanceCache& cache, const string& text, bool& hit); //parse an instance once per distinct text
+string encode_frame(const string& payload); //4-byte big-endian length followed by the payload
+bool write_frame(int fd, const string& payload); //send a length-prefixed message
+bool read_frame(int fd, string& payload); //receive a length-prefixed message, false on EOF or error
+map<string, string> parse_json_object(const string& text); //flat JSON object, values returned as raw strings
+string option_from_json(const string& value); //JSON true/false as the 1/0 that boolean options take, other values unchanged
+string json_string(const string& text); //quote and escape a string for JSON
+string json_improvement(const SearchEvent& event); //improvement event as streamed to clients
+chrono::steady_clock::time_point deadline_from(chrono::steady_clock::time_point start, double seconds); //start + seconds, or never if seconds is 0
+double record_deadline(DeadlineStats& stats, chrono::steady_clock::time_point deadline); //count a finished solve, returns seconds late (0 if on time)
+string deadline_summary(DeadlineStats& stats); //", deadlines: ..." for the final report, empty if no solve had one
+void wake_server(ServerState& state); //interrupt the accept loop's poll
+bool post_frames(ServerState& state, Connection& connection, const vector<string>& payloads); //queue messages for the accept loop to send, false if the client went away
+bool flush_connection(ServerState& state, Connection& connection); //send queued output without blocking, false if the client went away
+bool take_frame(string& buffer, string& payload); //cut the first complete length-prefixed frame off buffer, false if it has not fully arrived
+bool receive_requests(ServerState& state, const Config& defaults, Connection& connection); //read what has arrived without blocking and queue complete requests, false once the connection is closed
+bool queue_request(ServerState& state, const Config& defaults, Connection& connection, const string& request); //queue a request or answer it directly, false if the connection has to be closed
+void schedule_task(ServerState& state, unique_ptr<SolveTask> task); //put a task into the run queue and wake a worker
+void start_task(ServerState& state, const Config& defaults, SolveTask& task); //load the instance, then init_search
+bool run_slice(ServerState& state, const Config& defaults, SolveTask& task, int borrowed); //advance a solve by one time slice, with `borrowed` extra threads standing in for idle workers; false once it is finished
+void finish_task(ServerState& state, SolveTask& task, const string& error); //send the result or error and hand the connection back
+int run_server(const Config& config); //serve solve requests on a unix domain socket
+int run_client(const Config& config); //send one request to a server and print the streamed answers
+int run_batch(const Config& config); //solve the requests listed in a batch file on a worker pool
+bool apply_option(Config& config, const string& option, const string& value); //set one --option from its string value, false if unknown
+void load_config_file(Config& config, const string& path); //apply key = value lines or a flat JSON object, except options already given
+void apply_preset(Config& config, int n); //set the options of config.preset for an instance of size n, except pinned ones
+KernelSpeed measure_kernels(const Problem& problem, int tabu_tenure); //time swap deltas, Tabu Search iterations and cost evaluations on this instance
+string apply_auto_budget(Config& config, const Problem& problem); //--auto: fill unpinned search options from a cost model, returns a summary
 Config parse_arguments(int argc, char* argv[]); //parse command line arguments
 void print_usage();
 
@@ -54,129 +759,73 @@ int main(int argc, char* argv[]) {
     try {
         // Parse command line arguments
         Config config = parse_arguments(argc, argv);
-    //Load problem instance
-    cout << "Loading QAP instance from: " << config.input_file << endl;
-    Problem problem = load_problem(config.input_file);
-    cout << "Problem size: " << problem.n << "x" << problem.n << endl;
-    // Initialize random number generator
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_real_distribution<> dis(-1.0, 1.0);
-    // Initialize wolf pack
-    vector<Wolf> wolves(config.pack_size, Wolf(problem.n)); //initalize pack of wolves
-        Wolf alpha(problem.n), beta(problem.n), delta(problem.n); //initalize alpha, beta, delta wolves
-         // --- IGNORE ---
-        // Initialize wolves with random positions
-        for (auto& wolf : wolves) {
-            for (double& pos : wolf.position) {
-                pos = dis(gen);
-            }
-            // optional initial jitter
-            if (config.jitter > 0.0) {
-                uniform_real_distribution<> jdis(-config.jitter, config.jitter);
-                for (double& pos : wolf.position) pos += jdis(gen);
-            }
-            wolf.permutation = lvp_decode(wolf.position);
-            wolf.fitness = calculate_cost(problem, wolf.permutation);
+        if (!config.serve_socket.empty()) return run_server(config);
+        if (!config.client_socket.empty()) return run_client(config);
+        if (!config.batch_file.empty()) return run_batch(config);
+        //Load problem instance
+        cout << "Loading QAP instance from: " << config.input_file << endl;
+        Problem problem = load_problem(config.input_file);
+        cout << "Problem size: " << problem.n << "x" << problem.n << endl;
+        apply_preset(config, problem.n);
+        if (!config.preset.empty()) cout << "Preset: " << config.preset << endl;
+        if (!problem.derived->automorphisms.empty()) {
+            cout << "Distance symmetries: " << problem.derived->automorphisms.size()
+                 << (problem.derived->automorphisms.size() == AUTOMORPHISM_LIMIT ? "+" : "") << " (equivalent layouts are treated as one)" << endl;
         }
-    // Find initial alpha, beta, delta
-    sort(wolves.begin(), wolves.end(), 
-         [](const Wolf& a, const Wolf& b) { return a.fitness < b.fitness; });
-        alpha = wolves[0];
-        beta = wolves[1];
-        delta = wolves[2];
-    cout << "\nStarting Grey Wolf Optimizer + Tabu Search hybrid algorithm..." << endl;
-    cout << "Pack size: " << config.pack_size << ", Max iterations: " << config.max_iterations << endl;
-    cout << "Tabu Search iterations: " << config.ts_iterations << ", Tabu tenure: " << config.tabu_tenure << endl;
-    cout << "Initial best cost: " << alpha.fitness << endl << endl;
-        
-        // Main GWO loop
-        for (int iteration = 0; iteration < config.max_iterations; iteration++) {
-            double a = 2.0 - 2.0 * iteration / config.max_iterations; // Linearly decreasing from 2 to 0
-            for (auto& wolf : wolves) {
-                // Update position based on alpha, beta, delta
-                for (int i = 0; i < problem.n; i++) {
-                    // Alpha influence
-                    double r1 = dis(gen), r2 = dis(gen);
-                    double A1 = 2 * a * r1 - a;
-                    double C1 = 2 * r2;
-                    double D_alpha = abs(C1 * alpha.position[i] - wolf.position[i]);
-                    double X1 = alpha.position[i] - A1 * D_alpha;
-                    
-                    // Beta influence
-                    r1 = dis(gen); r2 = dis(gen);
-                    double A2 = 2 * a * r1 - a;
-                    double C2 = 2 * r2;
-                    double D_beta = abs(C2 * beta.position[i] - wolf.position[i]);
-                    double X2 = beta.position[i] - A2 * D_beta;
-                    
-                    // Delta influence
-                    r1 = dis(gen); r2 = dis(gen);
-                    double A3 = 2 * a * r1 - a;
-                    double C3 = 2 * r2;
-                    double D_delta = abs(C3 * delta.position[i] - wolf.position[i]);
-                    double X3 = delta.position[i] - A3 * D_delta;
-                    
-                    // Update position
-                    wolf.position[i] = (X1 + X2 + X3) / 3.0;
-                    
-                    // Clamp position to [-1, 1]
-                    wolf.position[i] = max(-1.0, min(1.0, wolf.position[i]));
-                }
-                
-                // Optional jitter before decode to increase discrete diversity
-                if (config.jitter > 0.0) {
-                    uniform_real_distribution<> jdis(-config.jitter, config.jitter);
-                    for (double& pos : wolf.position) {
-                        pos += jdis(gen);
-                        // Re-clamp after jitter to maintain bounds
-                        pos = max(-1.0, min(1.0, pos));
-                    }
-                }
-                // Convert to permutation and calculate fitness
-                wolf.permutation = lvp_decode(wolf.position);
-                wolf.fitness = calculate_cost(problem, wolf.permutation);
-            }
-            
-            // Sort wolves and update alpha, beta, delta
-            sort(wolves.begin(), wolves.end(), 
-                     [](const Wolf& a, const Wolf& b) { return a.fitness < b.fitness; });
-            
-            bool improved = false;
-            if (wolves[0].fitness < alpha.fitness) {
-                alpha = wolves[0];
-                improved = true;
-            }
-            if (wolves[1].fitness < beta.fitness) {
-                beta = wolves[1];
-            }
-            if (wolves[2].fitness < delta.fitness) {
-                delta = wolves[2];
-            }
-            
-            // Apply Tabu Search to alpha wolf (hybridization) every ts_every iterations
-            if (config.ts_iterations > 0 && config.ts_every > 0 && (iteration % config.ts_every == 0)) {
-                apply_tabu_search(problem, alpha, config.ts_iterations, config.tabu_tenure);
-            }
-            // Update wolves[0] with improved alpha
-            wolves[0] = alpha;
-            // Progress output
-            if ((iteration + 1) % 10 == 0 || improved) {
-                cout << "Iteration " << (iteration + 1) 
-                         << ": Best cost = " << alpha.fitness << endl;
+        ExactResult exact;
+        if (solve_exactly(problem, config, exact, deadline_from(chrono::steady_clock::now(), config.deadline))) {
+            print_exact(exact);
+            return 0;
+        }
+        if (exact.nodes > 0) {
+            cout << "Branch and bound stopped after " << exact.nodes << " nodes, running GWO + Tabu Search instead" << endl;
+        }
+        // the kernel timings behind --auto are only worth taking once a search is going to run
+        string budget = apply_auto_budget(config, problem);
+        if (!budget.empty()) cout << budget << endl;
+        if (config.clusters != 0) {
+            auto start = chrono::steady_clock::now();
+            Wolf decomposed(problem.n);
+            string summary;
+            if (solve_decomposed(problem, config, decomposed, summary)) {
+                cout << "Decomposition: " << summary << endl;
+                print_layout(decomposed.permutation, decomposed.fitness);
+                cout << "Solved in " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "s" << endl;
+                return 0;
             }
+            cout << "No cluster structure found, solving the whole instance" << endl;
         }
-        
-    // Final results
-    cout << "\n=== FINAL RESULTS ===" << endl;
-    cout << "Best cost found: " << alpha.fitness << endl;
-    cout << "Best assignment:" << endl;
-        
-        // Print final assignment using numeric facility indices starting from 0
-        for (int i = 0; i < problem.n; i++) {
-            cout << "  Facility " << i << " -> Location " << alpha.permutation[i] << endl;
+        if (config.multilevel > 0 && problem.n > config.multilevel) {
+            auto start = chrono::steady_clock::now();
+            Wolf refined(problem.n);
+            string summary;
+            solve_multilevel(problem, config, refined, summary);
+            cout << "Multilevel: " << summary << endl;
+            print_layout(refined.permutation, refined.fitness);
+            cout << "Solved in " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "s" << endl;
+            return 0;
         }
+        GwoSearch search(problem, config);
+        search.deadline = deadline_from(chrono::steady_clock::now(), config.deadline);
+        // Progress output happens on a consumer thread, so slow terminals or pipes never stall the search
+        EventStream output([](const SearchEvent& event) {
+            cout << "Iteration " << event.iteration 
+                 << ": Best cost = " << event.cost << endl;
+        });
+        search.progress = [&output](const SearchEvent& event) {
+            if (event.iteration % 10 == 0 || event.improved) output.publish(event);
+        };
+        init_search(search);
+        cout << "\nStarting Grey Wolf Optimizer + Tabu Search hybrid algorithm..." << endl;
+        cout << "Pack size: " << config.pack_size << ", Max iterations: " << config.max_iterations << endl;
+        cout << "Tabu Search iterations: " << config.ts_iterations << ", Tabu tenure: " << config.tabu_tenure << endl;
+        cout << "Initial best cost: " << search.alpha.fitness << endl << endl;
         
+        // Main GWO loop
+        while (search_step(search)) {}
+        output.close();
+        
+        print_results(search);
     } catch (const exception& e) {
         cerr << "Error: " << e.what() << endl;
         return 1;
@@ -185,184 +834,3238 @@ int main(int argc, char* argv[]) {
     return 0;
 }
 
-Problem load_problem(const string& filename) {
-    ifstream file(filename);
-    if (!file.is_open()) {
-        throw runtime_error("Cannot open file: " + filename);
+ThreadPool::ThreadPool(int count) : threads(count) {
+    for (int w = 1; w < threads; w++) {
+        helpers.emplace_back([this, w]() {
+            long long seen = 0;
+            while (true) {
+                const function<void(int)>* body;
+                {
+                    unique_lock<mutex> guard(lock);
+                    wake.wait(guard, [&]() { return stopping || generation != seen; });
+                    if (stopping) return;
+                    seen = generation;
+                    body = job;
+                }
+                (*body)(w);
+                lock_guard<mutex> guard(lock);
+                if (--running == 0) finished.notify_one();
+            }
+        });
     }
-    
-    int n;
-    file >> n;
-    
-    Problem problem(n);
-    
-    // Read distance matrix
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            file >> problem.distance[i][j];
-        }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
     }
-    
-    // Read flow matrix
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            file >> problem.flow[i][j];
+    wake.notify_all();
+    for (auto& helper : helpers) helper.join();
+}
+
+void ThreadPool::run(const function<void(int worker)>& body) {
+    {
+        lock_guard<mutex> guard(lock);
+        job = &body;
+        running = threads - 1;
+        generation++;
+    }
+    wake.notify_all();
+    body(0);
+    unique_lock<mutex> guard(lock);
+    finished.wait(guard, [&]() { return running == 0; });
+}
+
+bool better_move(const MoveChoice& a, const MoveChoice& b) {
+    if (a.i == -1) return false;
+    if (b.i == -1) return true;
+    return tie(a.score, a.i, a.j) < tie(b.score, b.i, b.j);
+}
+
+EventStream::EventStream(function<void(const SearchEvent&)> handle, size_t capacity) : queue(capacity) {
+    consumer = thread([this, handle]() {
+        SearchEvent event;
+        int idle = 0;
+        while (true) {
+            if (queue.try_pop(event)) {
+                handle(event);
+                idle = 0;
+            } else if (closed.load(memory_order_acquire)) {
+                // close() stores `closed` after its last push, so one more pop drains the queue
+                while (queue.try_pop(event)) handle(event);
+                return;
+            } else if (++idle < 64) {
+                this_thread::yield();
+            } else {
+                this_thread::sleep_for(chrono::microseconds(200));
+            }
         }
+    });
+}
+
+void EventStream::publish(SearchEvent event) {
+    if (has_pending && queue.try_push(pending)) has_pending = false;
+    if (has_pending || !queue.try_push(event)) {
+        // queue full: keep only the newest waiting event, it supersedes the older ones
+        if (!has_pending || event.improved || !pending.improved) pending = move(event);
+        has_pending = true;
     }
-    
-    file.close();
-    return problem;
 }
 
-long long calculate_cost(const Problem& problem, const vector<int>& permutation) {
-    long long cost = 0;
-    for (int i = 0; i < problem.n; i++) {
-        for (int j = 0; j < problem.n; j++) {
-            cost += static_cast<long long>(problem.flow[i][j]) * static_cast<long long>(problem.distance[permutation[i]][permutation[j]]);
+void EventStream::close() {
+    if (closed.load(memory_order_relaxed)) return;
+    while (has_pending && !queue.try_push(pending)) this_thread::yield();
+    has_pending = false;
+    closed.store(true, memory_order_release);
+    consumer.join();
+}
+
+GwoSearch::GwoSearch(const Problem& p, const Config& c)
+    : problem(p), config(c), wolves(c.pack_size, Wolf(p.n)), alpha(p.n), beta(p.n), delta(p.n),
+      archive(c.elite_size, c.elite_distance), top(c.top_k), tabu_memory(p.n, c.freq_penalty, c.solution_tabu) {
+    archive.automorphisms = &p.derived->automorphisms;
+    top.automorphisms = &p.derived->automorphisms;
+    if (config.threads > 1) pool = make_unique<ThreadPool>(config.threads);
+    // a fixed seed makes runs reproducible, e.g. for server requests and benchmarks
+    if (config.seed != 0) {
+        gen.seed(static_cast<mt19937::result_type>(config.seed));
+    } else {
+        random_device rd;
+        gen.seed(rd());
+    }
+}
+
+template <typename Decoder, typename LocalSearch>
+array<int, 3> evaluate_pack(GwoSearch& search) {
+    const Problem& problem = search.problem;
+    vector<Wolf>& wolves = search.wolves;
+    int pack = static_cast<int>(wolves.size());
+    int threads = search.pool ? search.pool->threads : 1;
+    search.hashes.resize(pack);
+    // each worker keeps its own top three, ordered by (fitness, hash, index) so ties never
+    // depend on which thread finished first
+    auto key = [&](int k) { return make_tuple(wolves[k].fitness, search.hashes[k], k); };
+    vector<array<int, 3>> partial(threads);
+    vector<long long> polished(threads, 0); //swap deltas evaluated by each worker's polishing
+    // small packs use smaller blocks so every worker still gets wolves to evaluate
+    int block_size = max(1, min(BATCH_BLOCK, (pack + threads - 1) / threads));
+    auto work = [&](int worker) {
+        array<int, 3> top = {-1, -1, -1};
+        const vector<int>* block[BATCH_BLOCK];
+        long long costs[BATCH_BLOCK];
+        for (int begin = worker * block_size; begin < pack; begin += threads * block_size) {
+            int count = min(block_size, pack - begin);
+            for (int b = 0; b < count; b++) {
+                Wolf& wolf = wolves[begin + b];
+                wolf.permutation = Decoder::decode(wolf.position);
+                block[b] = &wolf.permutation;
+            }
+            evaluate_block(problem, block, count, costs);
+            for (int b = 0; b < count; b++) {
+                int k = begin + b;
+                wolves[k].fitness = costs[b];
+                if constexpr (LocalSearch::active) {
+                    polished[worker] += LocalSearch::apply(problem, wolves[k], search.config.polish_looks);
+                    learn(search.config, wolves[k]);
+                }
+                search.hashes[k] = hash_permutation(wolves[k].permutation);
+                int candidate = k;
+                for (int& slot : top) {
+                    if (slot == -1 || key(candidate) < key(slot)) swap(slot, candidate);
+                    if (candidate == -1) break;
+                }
+            }
         }
+        partial[worker] = top;
+    };
+    if (threads > 1) {
+        search.pool->run(work);
+    } else {
+        work(0);
     }
-    return cost;
+    search.evaluations += pack + accumulate(polished.begin(), polished.end(), 0LL);
+
+    array<int, 3> best = {-1, -1, -1};
+    for (const auto& top : partial) {
+        for (int candidate : top) {
+            for (int& slot : best) {
+                if (candidate == -1) break;
+                if (slot == -1 || key(candidate) < key(slot)) swap(slot, candidate);
+            }
+        }
+    }
+    return best;
 }
 
-vector<int> lvp_decode(const vector<double>& position) {
-    int n = position.size();
-    vector<pair<double, int>> sorted_positions;
+double search_seconds(const GwoSearch& search) {
+    return chrono::duration<double>(chrono::steady_clock::now() - search.start).count();
+}
 
-    for (int i = 0; i < n; i++) {
-        sorted_positions.push_back({position[i], i});
+string engine_name(const Config& config) {
+    return string(LvpDecoder::name) + "/" + config.a_schedule + "/" + config.coefficients + "/" + config.steps + "/" +
+           config.polish + "/" + (config.target != LLONG_MIN ? TargetStop::name : BudgetStop::name);
+}
+
+// Registers one GwoEngine per combination visited
+struct EngineCollector {
+    map<string, GwoEngineEntry>& registry;
+    template <typename Decoder, typename Schedule, typename Coefficients, typename Steps, typename LocalSearch, typename Stop>
+    void apply() {
+        using Engine = GwoEngine<Decoder, GwoUpdate<Schedule, Coefficients, Steps>, LocalSearch, Stop>;
+        registry[Engine::name()] = {Engine::init, Engine::step};
     }
+};
 
-    sort(sorted_positions.begin(), sorted_positions.end(), greater<>());
+const map<string, GwoEngineEntry>& engine_registry() {
+    static const map<string, GwoEngineEntry> registry = [] {
+        map<string, GwoEngineEntry> engines;
+        EngineCollector collector{engines};
+        Combinations<TypeList<>, TypeList<LvpDecoder>, TypeList<LinearSchedule, QuadraticSchedule>,
+                     TypeList<UniformCoefficients, LogisticCoefficients, TentCoefficients>, TypeList<PlainSteps, LevySteps>,
+                     TypeList<NoPolish, FirstImprovementPolish, BestImprovementPolish>, TypeList<BudgetStop, TargetStop>>::visit(collector);
+        return engines;
+    }();
+    return registry;
+}
 
-    vector<int> permutation(n);
-    for (int i = 0; i < n; i++) {
-        permutation[sorted_positions[i].second] = i;
+void init_search(GwoSearch& search) {
+    const map<string, GwoEngineEntry>& registry = engine_registry();
+    auto found = registry.find(engine_name(search.config));
+    if (found == registry.end()) throw invalid_argument("no engine for " + engine_name(search.config));
+    search.engine = &found->second;
+    search.engine->init(search);
+}
+
+template <typename Decoder, typename Update, typename LocalSearch, typename Stop>
+void GwoEngine<Decoder, Update, LocalSearch, Stop>::init(GwoSearch& search) {
+    search.start = chrono::steady_clock::now();
+    seed_pack(search);
+    init_leaders(search, evaluate_pack<Decoder, LocalSearch>(search));
+    search.longest_step = chrono::steady_clock::now() - search.start;
+}
+
+void seed_pack(GwoSearch& search) {
+    const Config& config = search.config;
+    mt19937& gen = search.gen;
+    uniform_real_distribution<> dis(-1.0, 1.0);
+    // Initialize wolves with random positions
+    for (auto& wolf : search.wolves) {
+        for (double& pos : wolf.position) {
+            pos = dis(gen);
+        }
+        // optional initial jitter
+        if (config.jitter > 0.0) {
+            uniform_real_distribution<> jdis(-config.jitter, config.jitter);
+            for (double& pos : wolf.position) pos += jdis(gen);
+        }
     }
+    if (config.opposition > 0) opposition_init(search);
+}
 
-    return permutation;
+void init_leaders(GwoSearch& search, const array<int, 3>& best) {
+    const vector<Wolf>& wolves = search.wolves;
+    // Find initial alpha, beta, delta
+    search.alpha = wolves[best[0]];
+    search.beta = wolves[best[1]];
+    search.delta = wolves[best[2]];
+    for (const auto& wolf : wolves) {
+        elite_insert(search.archive, wolf);
+        topk_offer(search.top, wolf.permutation, wolf.fitness);
+    }
 }
 
-void apply_tabu_search(const Problem& problem, Wolf& wolf, int ts_iterations, int tabu_tenure) {
-    deque<pair<int, int>> tabu_list;
-    vector<int> current_solution = wolf.permutation;
-    vector<int> best_solution = current_solution;
-    long long current_cost = wolf.fitness;
-    long long best_cost = current_cost;
-    static long long global_best = LLONG_MAX;  // Track global best across all TS calls
-    if (best_cost < global_best) {
-        global_best = best_cost;
+void opposition_init(GwoSearch& search) {
+    vector<Wolf>& wolves = search.wolves;
+    int pack = static_cast<int>(wolves.size());
+    // positions are drawn from [-1, 1], so the opposite point of x is -x; its layout is the
+    // original one mirrored, every facility moving from location l to n - 1 - l
+    vector<vector<double>> positions;
+    positions.reserve(2 * pack);
+    for (const auto& wolf : wolves) positions.push_back(wolf.position);
+    for (const auto& wolf : wolves) {
+        vector<double> opposite = wolf.position;
+        for (double& pos : opposite) pos = -pos;
+        positions.push_back(move(opposite));
     }
-    
-    for (int iter = 0; iter < ts_iterations; iter++) {
-    vector<int> best_neighbor = current_solution;
-        long long best_neighbor_cost = LLONG_MAX;
-        int best_i = -1, best_j = -1;
-        
-        // Explore 2-opt neighborhood
-        for (int i = 0; i < problem.n - 1; i++) {
-            for (int j = i + 1; j < problem.n; j++) {
-                // Create neighbor by swapping positions i and j
-                vector<int> neighbor = current_solution;
-                std::swap(neighbor[i], neighbor[j]);
-                
-                long long neighbor_cost = calculate_cost(problem, neighbor);
-                
-                // Check if move is tabu
-                bool is_tabu = false;
-                for (const auto& tabu_move : tabu_list) {
-                    if ((tabu_move.first == i && tabu_move.second == j) ||
-                        (tabu_move.first == j && tabu_move.second == i)) {
-                        is_tabu = true;
-                        break;
-                    }
-                }
-                //Accept move if not tabu or if it improves global best (aspiration criterion)
-                if (!is_tabu || neighbor_cost < global_best) {
-                    if (neighbor_cost < best_neighbor_cost) {
-                        best_neighbor = neighbor;
-                        best_neighbor_cost = neighbor_cost;
-                        best_i = i;
-                        best_j = j;
-                    }
-                }
-            }
+    vector<vector<int>> layouts;
+    layouts.reserve(positions.size());
+    for (const auto& position : positions) layouts.push_back(lvp_decode(position));
+    vector<long long> costs;
+    evaluate_batch(search.problem, layouts, costs, search.pool.get());
+    search.evaluations += static_cast<long long>(layouts.size());
+    // keep the cheapest half; ties go to the lower index, so the result does not depend on threads
+    vector<int> order(positions.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&](int x, int y) { return costs[x] < costs[y]; });
+    for (int k = 0; k < pack; k++) wolves[k].position = positions[order[k]];
+}
+
+bool quasi_opposition_jump(GwoSearch& search) {
+    const Problem& problem = search.problem;
+    vector<Wolf>& wolves = search.wolves;
+    int n = problem.n;
+    int pack = static_cast<int>(wolves.size());
+    // opposite points are taken within the range the pack currently spans in each dimension, so
+    // the jumps stay meaningful once the pack has contracted; a quasi-opposite point lies between
+    // the centre of that range and the opposite point
+    vector<double> low(n, 1.0), high(n, -1.0);
+    for (const auto& wolf : wolves) {
+        for (int i = 0; i < n; i++) {
+            low[i] = min(low[i], wolf.position[i]);
+            high[i] = max(high[i], wolf.position[i]);
         }
-        
-        // If no valid move found (all moves are tabu and don't satisfy aspiration), break
-        if (best_i == -1) break;
-        
-        // Update current solution
-        current_solution = best_neighbor;
-        current_cost = best_neighbor_cost;
+    }
+    uniform_real_distribution<> unit(0.0, 1.0);
+    vector<vector<double>> positions(pack, vector<double>(n));
+    vector<vector<int>> layouts(pack);
+    for (int k = 0; k < pack; k++) {
+        for (int i = 0; i < n; i++) {
+            double centre = (low[i] + high[i]) / 2.0;
+            double opposite = low[i] + high[i] - wolves[k].position[i];
+            positions[k][i] = centre + unit(search.gen) * (opposite - centre);
+        }
+        layouts[k] = lvp_decode(positions[k]);
+    }
+    vector<long long> costs;
+    evaluate_batch(problem, layouts, costs, search.pool.get());
+    search.evaluations += pack;
+    bool improved = false;
+    for (int k = 0; k < pack; k++) {
+        if (costs[k] >= wolves[k].fitness) continue;
+        Wolf& wolf = wolves[k];
+        wolf.position = move(positions[k]);
+        wolf.permutation = move(layouts[k]);
+        wolf.fitness = costs[k];
+        elite_insert(search.archive, wolf);
+        topk_offer(search.top, wolf.permutation, wolf.fitness);
+        if (wolf.fitness < search.alpha.fitness) {
+            search.alpha = wolf;
+            improved = true;
+        }
+    }
+    return improved;
+}
 
-        // Update best solution
-        if (current_cost < best_cost) {
-            best_solution = current_solution;
-            best_cost = current_cost;
-            if (best_cost < global_best) {
-                global_best = best_cost;
-            }
+template <typename Schedule, typename Coefficients, typename Steps>
+void GwoUpdate<Schedule, Coefficients, Steps>::apply(GwoSearch& search) {
+    const Problem& problem = search.problem;
+    const Config& config = search.config;
+    mt19937& gen = search.gen;
+    Coefficients r(search);
+    Steps step;
+    const Wolf& alpha = search.alpha;
+    const Wolf& beta = search.beta;
+    const Wolf& delta = search.delta;
+    double a = Schedule::a(search.iteration, config.max_iterations);
+    for (auto& wolf : search.wolves) {
+        // Update position based on alpha, beta, delta
+        for (int i = 0; i < problem.n; i++) {
+            // Alpha influence
+            double r1 = r(gen), r2 = r(gen);
+            double A1 = 2 * a * r1 - a;
+            double C1 = 2 * r2;
+            double D_alpha = abs(C1 * alpha.position[i] - wolf.position[i]);
+            double X1 = alpha.position[i] - A1 * D_alpha;
+            
+            // Beta influence
+            r1 = r(gen); r2 = r(gen);
+            double A2 = 2 * a * r1 - a;
+            double C2 = 2 * r2;
+            double D_beta = abs(C2 * beta.position[i] - wolf.position[i]);
+            double X2 = beta.position[i] - A2 * D_beta;
+            
+            // Delta influence
+            r1 = r(gen); r2 = r(gen);
+            double A3 = 2 * a * r1 - a;
+            double C3 = 2 * r2;
+            double D_delta = abs(C3 * delta.position[i] - wolf.position[i]);
+            double X3 = delta.position[i] - A3 * D_delta;
+            
+            // Update position
+            wolf.position[i] = (X1 + X2 + X3) / 3.0;
+            if constexpr (Steps::active) wolf.position[i] += LEVY_SCALE * step(gen) * (wolf.position[i] - alpha.position[i]);
+            
+            // Clamp position to [-1, 1]
+            wolf.position[i] = max(-1.0, min(1.0, wolf.position[i]));
         }
         
-        // Add move to tabu list
-        tabu_list.push_back({best_i, best_j});
-        if (static_cast<int>(tabu_list.size()) > tabu_tenure) {
-            tabu_list.pop_front();
+        // Optional jitter before decode to increase discrete diversity
+        if (config.jitter > 0.0) {
+            uniform_real_distribution<> jdis(-config.jitter, config.jitter);
+            for (double& pos : wolf.position) {
+                pos += jdis(gen);
+                // Re-clamp after jitter to maintain bounds
+                pos = max(-1.0, min(1.0, pos));
+            }
         }
     }
-    
-    // Update wolf with best solution found
-    wolf.permutation = best_solution;
-    wolf.fitness = best_cost;
 }
 
-Config parse_arguments(int argc, char* argv[]) {
-    Config config;
+bool BudgetStop::proceed(const GwoSearch& search) {
+    const Config& config = search.config;
+    if (search.iteration >= config.max_iterations) return false;
+    if (config.time_limit > 0.0 && search_seconds(search) >= config.time_limit) return false;
+    // do not start an iteration that could end after the deadline; the longest one so far is the
+    // estimate because path relinking makes some iterations much longer than the average
+    if (search.deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() + search.longest_step >= search.deadline) return false;
+    return true;
+}
 
-    for (int i = 1; i < argc; i++) {
-        string arg = argv[i];
+bool TargetStop::proceed(const GwoSearch& search) {
+    return search.alpha.fitness > search.config.target && BudgetStop::proceed(search);
+}
+
+bool search_step(GwoSearch& search) {
+    if (!search.step.active && !search.engine->step(search)) return false;
+    resume_step(search, chrono::steady_clock::time_point::max(), nullptr);
+    return true;
+}
+
+bool search_until(GwoSearch& search, chrono::steady_clock::time_point until, const function<bool()>& interrupt) {
+    // the update and pack evaluation of an iteration run whole; its Tabu Search and path
+    // relinking stop between two moves once the time is up, so a paused iteration needs at
+    // most one move to resume
+    do {
+        if (!search.step.active && !search.engine->step(search)) return false;
+        if (!resume_step(search, until, interrupt)) return true;
+    } while (chrono::steady_clock::now() < until && !(interrupt && interrupt()));
+    return true;
+}
+
+template <typename Decoder, typename Update, typename LocalSearch, typename Stop>
+bool GwoEngine<Decoder, Update, LocalSearch, Stop>::step(GwoSearch& search) {
+    if (!Stop::proceed(search)) return false;
+    auto step_start = chrono::steady_clock::now();
+    Update::apply(search);
+    // Convert to permutations, calculate fitness and find the three best wolves
+    finish_step(search, evaluate_pack<Decoder, LocalSearch>(search));
+    search.step.work = chrono::steady_clock::now() - step_start;
+    return true;
+}
+
+void finish_step(GwoSearch& search, const array<int, 3>& best) {
+    const Problem& problem = search.problem;
+    const Config& config = search.config;
+    int iteration = search.iteration;
+    vector<Wolf>& wolves = search.wolves;
+    Wolf& alpha = search.alpha;
+    Wolf& beta = search.beta;
+    Wolf& delta = search.delta;
+    EliteArchive& archive = search.archive;
+    TopKCollector& top = search.top;
+    TabuMemory& tabu_memory = search.tabu_memory;
+
+    bool improved = false;
+    if (wolves[best[0]].fitness < alpha.fitness) {
+        alpha = wolves[best[0]];
+        improved = true;
+    }
+    if (wolves[best[1]].fitness < beta.fitness) {
+        beta = wolves[best[1]];
+    }
+    if (wolves[best[2]].fitness < delta.fitness) {
+        delta = wolves[best[2]];
+    }
+    for (const auto& wolf : wolves) {
+        elite_insert(archive, wolf);
+        topk_offer(top, wolf.permutation, wolf.fitness);
+    }
+
+    // Keep beta and delta distinct from alpha (and each other, also up to symmetry) by promoting archive entries
+    uint64_t alpha_hash = layout_hash(alpha.permutation, archive.automorphisms);
+    uint64_t beta_hash = layout_hash(beta.permutation, archive.automorphisms);
+    uint64_t delta_hash = layout_hash(delta.permutation, archive.automorphisms);
+    if (beta_hash == alpha_hash || delta_hash == alpha_hash || delta_hash == beta_hash) {
+        size_t next = 0;
+        auto promote = [&](uint64_t& leader_hash, Wolf& leader, uint64_t excluded) {
+            for (; next < archive.entries.size(); next++) {
+                const EliteEntry& entry = archive.entries[next];
+                if (entry.hash != alpha_hash && entry.hash != excluded) {
+                    leader = elite_wolf(entry);
+                    leader_hash = entry.hash;
+                    next++;
+                    return;
+                }
+            }
+        };
+        if (beta_hash == alpha_hash) promote(beta_hash, beta, alpha_hash);
+        if (delta_hash == alpha_hash || delta_hash == beta_hash) promote(delta_hash, delta, beta_hash);
+    }
+    
+    // Apply Tabu Search to alpha wolf (hybridization) every ts_every iterations
+    StepState& step = search.step;
+    step.active = true;
+    step.phase = StepPhase::Tabu;
+    step.best_index = best[0];
+    step.improved = improved;
+    step.restart = false;
+    if (config.ts_iterations > 0 && config.ts_every > 0 && (iteration % config.ts_every == 0)) {
+        if (config.elite_restart > 0 && search.stagnation >= max(config.elite_restart, search.next_restart) && archive.entries.size() > 1) {
+            // alpha's neighborhood looks exhausted, so spend this Tabu Search on another elite
+            // solution; the following ones go back to alpha until the next restart is due
+            search.next_restart = search.stagnation + config.elite_restart;
+            size_t pick = 1 + search.restart_index++ % (archive.entries.size() - 1);
+            if (archive.entries[pick].hash == alpha_hash) pick = 0;
+            step.restart = true;
+            step.restart_wolf = elite_wolf(archive.entries[pick]);
+            step.tabu = make_unique<TabuRun>(problem, step.restart_wolf, config.ts_iterations, config.tabu_tenure, tabu_memory, search.pool.get());
+        } else {
+            step.before = alpha.fitness;
+            step.tabu = make_unique<TabuRun>(problem, alpha, config.ts_iterations, config.tabu_tenure, tabu_memory, search.pool.get());
+        }
+    }
+}
+
+bool resume_step(GwoSearch& search, chrono::steady_clock::time_point until, const function<bool()>& interrupt) {
+    const Problem& problem = search.problem;
+    const Config& config = search.config;
+    Wolf& alpha = search.alpha;
+    StepState& step = search.step;
+    auto resumed = chrono::steady_clock::now();
+    auto pause = [&]() {
+        auto now = chrono::steady_clock::now();
+        if (now < until && !(interrupt && interrupt())) return false;
+        step.work += now - resumed;
+        return true;
+    };
+    // a refined solution is offered to the archive and top-K, and replaces alpha if it is cheaper
+    auto keep = [&](Wolf& wolf) {
+        learn(config, wolf);
+        elite_insert(search.archive, wolf);
+        topk_offer(search.top, wolf.permutation, wolf.fitness);
+        if (wolf.fitness < alpha.fitness) {
+            alpha = wolf;
+            step.improved = true;
+        }
+    };
+    while (true) {
+        switch (step.phase) {
+        case StepPhase::Tabu:
+            if (step.tabu) {
+                while (step.tabu->advance(search.pool.get())) {
+                    if (pause()) return false;
+                }
+                search.evaluations += step.tabu->finish();
+                step.tabu.reset();
+                if (step.restart) {
+                    keep(step.restart_wolf);
+                } else {
+                    keep(alpha);
+                    if (alpha.fitness < step.before) step.improved = true;
+                }
+            }
+            // Path relinking: explore the swap paths between alpha and other elite solutions,
+            // then intensify around the best intermediates with short Tabu Search runs
+            step.guides.clear();
+            step.guide = 0;
+            if (config.pr_every > 0 && (search.iteration + 1) % config.pr_every == 0 && search.archive.entries.size() > 1) {
+                for (const auto& entry : search.archive.entries) {
+                    if (static_cast<int>(step.guides.size()) >= config.pr_pairs) break;
+                    if (entry.permutation != alpha.permutation) step.guides.push_back(elite_wolf(entry));
+                }
+            }
+            step.phase = StepPhase::Relink;
+            break;
+        case StepPhase::Relink:
+            if (step.guide == step.guides.size()) {
+                step.phase = StepPhase::Tail;
+                break;
+            }
+            // both paths of a guide are walked before their intermediates are searched, so they
+            // start from the same alpha
+            if (!step.relink) {
+                step.starts.clear();
+                step.relink_back = false;
+                step.relink = make_unique<RelinkRun>(problem, alpha, step.guides[step.guide].permutation, 2);
+            }
+            while (step.relink->advance()) {
+                if (pause()) return false;
+            }
+            for (auto& wolf : step.relink->best) step.starts.push_back(move(wolf));
+            if (!step.relink_back) {
+                step.relink = make_unique<RelinkRun>(problem, step.guides[step.guide], alpha.permutation, 2);
+                step.relink_back = true;
+                break;
+            }
+            step.relink.reset();
+            step.next_start = 0;
+            step.phase = StepPhase::Starts;
+            break;
+        case StepPhase::Starts:
+            if (step.next_start == step.starts.size()) {
+                step.guide++;
+                step.phase = StepPhase::Relink;
+                break;
+            }
+            if (config.pr_ts_iterations > 0) {
+                if (!step.tabu) {
+                    step.tabu = make_unique<TabuRun>(problem, step.starts[step.next_start], config.pr_ts_iterations, config.tabu_tenure,
+                                                     search.tabu_memory, search.pool.get());
+                }
+                while (step.tabu->advance(search.pool.get())) {
+                    if (pause()) return false;
+                }
+                search.evaluations += step.tabu->finish();
+                step.tabu.reset();
+            }
+            keep(step.starts[step.next_start++]);
+            break;
+        case StepPhase::Tail: {
+            bool improved = step.improved;
+            // a pack that has stalled for a while jumps to quasi-opposite points where those are cheaper
+            if (config.opposition > 0 && !improved && (search.stagnation + 1) % config.opposition == 0) {
+                improved = quasi_opposition_jump(search);
+            }
+            search.stagnation = improved ? 0 : search.stagnation + 1;
+            if (improved) search.next_restart = 0;
+            // Replace this iteration's best wolf with the (possibly improved) alpha
+            search.wolves[step.best_index] = alpha;
+            if (search.progress) {
+                SearchEvent event;
+                event.improved = improved;
+                event.iteration = search.iteration + 1;
+                event.cost = alpha.fitness;
+                if (improved) event.permutation = alpha.permutation;
+                event.seconds = search_seconds(search);
+                event.evaluations = search.evaluations;
+                search.progress(event);
+            }
+            search.iteration++;
+            step.active = false;
+            search.longest_step = max(search.longest_step, step.work + (chrono::steady_clock::now() - resumed));
+            return true;
+        }
+        }
+    }
+}
+
+void print_results(const GwoSearch& search) {
+    const Wolf& alpha = search.alpha;
+    const EliteArchive& archive = search.archive;
+    print_layout(alpha.permutation, alpha.fitness);
+    if (search.config.top_k > 0) {
+        print_top_k(search.top);
+    } else if (archive.entries.size() > 1) {
+        cout << "\nElite layouts (" << archive.entries.size() << " distinct):" << endl;
+        for (size_t k = 0; k < archive.entries.size(); k++) {
+            cout << "  #" << (k + 1) << " cost " << archive.entries[k].cost << ":";
+            for (int loc : archive.entries[k].permutation) cout << " " << loc;
+            cout << endl;
+        }
+    }
+    const TabuMemory& memory = search.tabu_memory;
+    if (memory.solution_window > 0) {
+        cout << "\nSolution tabu: " << memory.cycles_blocked << " of " << memory.window_moves << " Tabu Search moves would have revisited one of the last "
+             << memory.solution_window << " solutions";
+        if (memory.cycles_blocked > 0) {
+            ostringstream average;
+            average << fixed << setprecision(1) << static_cast<double>(memory.cycle_length_sum) / memory.cycles_blocked;
+            cout << " (cycle length " << average.str() << " on average, longest " << memory.longest_cycle << ")";
+        }
+        cout << endl;
+    }
+}
+
+Problem load_problem(const string& filename) {
+    ifstream file(filename);
+    if (!file.is_open()) {
+        throw runtime_error("Cannot open file: " + filename);
+    }
+    
+    Problem problem = parse_problem(file);
+    file.close();
+    return problem;
+}
+
+Problem parse_problem(istream& in) {
+    Matrix distance, flow;
+    read_matrices(in, distance, flow);
+    return make_problem(move(distance), move(flow));
+}
+
+void read_matrices(istream& in, Matrix& distance, Matrix& flow) {
+    int n;
+    if (!(in >> n) || n < 1) {
+        throw runtime_error("Invalid instance: missing or non-positive problem size");
+    }
+    // rows are only allocated as their entries arrive, so a header announcing a huge n with
+    // little data behind it (e.g. a short server request) fails fast instead of allocating n*n
+    auto read_matrix = [&](Matrix& matrix) {
+        matrix.clear();
+        for (int i = 0; i < n; i++) {
+            vector<int> row;
+            row.reserve(min(n, 4096));
+            int value;
+            for (int j = 0; j < n && in >> value; j++) row.push_back(value);
+            if (static_cast<int>(row.size()) < n) {
+                throw runtime_error("Invalid instance: expected two " + to_string(n) + "x" + to_string(n) + " matrices");
+            }
+            matrix.push_back(move(row));
+        }
+    };
+    read_matrix(distance);
+    read_matrix(flow);
+}
+
+Problem make_problem(Matrix distance, Matrix flow) {
+    auto derived = derive_problem(distance, flow);
+    return Problem(make_shared<const Matrix>(move(distance)), make_shared<const Matrix>(move(flow)), derived);
+}
+
+long long calculate_cost(const Problem& problem, const vector<int>& permutation) {
+    long long cost = 0;
+    if (problem.derived->sparse_flow) {
+        for (int i = 0; i < problem.n; i++) {
+            const vector<int>& dist_row = problem.distance[permutation[i]];
+            for (const auto& entry : problem.derived->flow_rows[i]) {
+                cost += static_cast<long long>(entry.second) * static_cast<long long>(dist_row[permutation[entry.first]]);
+            }
+        }
+        return cost;
+    }
+    for (int i = 0; i < problem.n; i++) {
+        for (int j = 0; j < problem.n; j++) {
+            cost += static_cast<long long>(problem.flow[i][j]) * static_cast<long long>(problem.distance[permutation[i]][permutation[j]]);
+        }
+    }
+    return cost;
+}
+
+shared_ptr<const ProblemDerived> derive_problem(const Matrix& distance, const Matrix& flow) {
+    int n = static_cast<int>(distance.size());
+    auto derived = make_shared<ProblemDerived>();
+    derived->symmetric = true;
+    long long nonzero = 0;
+    derived->flow_rows.resize(n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (distance[i][j] != distance[j][i] || flow[i][j] != flow[j][i]) derived->symmetric = false;
+            if (flow[i][j] != 0) {
+                derived->flow_rows[i].push_back({j, flow[i][j]});
+                nonzero++;
+            }
+        }
+    }
+    derived->sparse_flow = 2 * nonzero <= static_cast<long long>(n) * n;
+    long long max_flow = 0, max_distance = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            max_flow = max(max_flow, llabs(static_cast<long long>(flow[i][j])));
+            max_distance = max(max_distance, llabs(static_cast<long long>(distance[i][j])));
+        }
+    }
+    derived->narrow_rows = n > 0 && max_flow * max_distance <= INT_MAX / n;
+    derived->automorphisms = find_automorphisms(distance);
+    if (!derived->sparse_flow) derived->flow_rows.clear();
+    return derived;
+}
+
+long long compute_swap_delta(const Problem& problem, const vector<int>& permutation, int r, int s) {
+    // only the terms in rows and columns r and s change; this is Taillard's delta for asymmetric QAP.
+    // Differences are taken in long long: entries of opposite sign near INT_MAX overflow int
+    const vector<vector<int>>& f = problem.flow;
+    const vector<vector<int>>& d = problem.distance;
+    int pr = permutation[r], ps = permutation[s];
+    if (problem.derived->symmetric) {
+        // with symmetric matrices the row and column terms coincide
+        long long delta = (static_cast<long long>(f[r][r]) - f[s][s]) * (static_cast<long long>(d[ps][ps]) - d[pr][pr]);
+        long long sum = 0;
+        if (problem.derived->sparse_flow) {
+            // only facilities with flow to r or s contribute
+            for (const auto& entry : problem.derived->flow_rows[r]) {
+                int k = entry.first;
+                if (k == r || k == s) continue;
+                sum += entry.second * (static_cast<long long>(d[permutation[k]][ps]) - d[permutation[k]][pr]);
+            }
+            for (const auto& entry : problem.derived->flow_rows[s]) {
+                int k = entry.first;
+                if (k == r || k == s) continue;
+                sum -= entry.second * (static_cast<long long>(d[permutation[k]][ps]) - d[permutation[k]][pr]);
+            }
+            return delta + 2 * sum;
+        }
+        for (int k = 0; k < problem.n; k++) {
+            if (k == r || k == s) continue;
+            int pk = permutation[k];
+            sum += (static_cast<long long>(f[k][r]) - f[k][s]) * (static_cast<long long>(d[pk][ps]) - d[pk][pr]);
+        }
+        return delta + 2 * sum;
+    }
+    long long delta = f[r][r] * (static_cast<long long>(d[ps][ps]) - d[pr][pr])
+                    + f[r][s] * (static_cast<long long>(d[ps][pr]) - d[pr][ps])
+                    + f[s][r] * (static_cast<long long>(d[pr][ps]) - d[ps][pr])
+                    + f[s][s] * (static_cast<long long>(d[pr][pr]) - d[ps][ps]);
+    for (int k = 0; k < problem.n; k++) {
+        if (k == r || k == s) continue;
+        int pk = permutation[k];
+        delta += f[k][r] * (static_cast<long long>(d[pk][ps]) - d[pk][pr])
+               + f[k][s] * (static_cast<long long>(d[pk][pr]) - d[pk][ps])
+               + f[r][k] * (static_cast<long long>(d[ps][pk]) - d[pr][pk])
+               + f[s][k] * (static_cast<long long>(d[pr][pk]) - d[ps][pk]);
+    }
+    return delta;
+}
+
+void evaluate_block(const Problem& problem, const vector<int>* const* permutations, int count, long long* costs) {
+    const ProblemDerived& derived = *problem.derived;
+    long long sums[BATCH_BLOCK] = {0};
+    // facility-major order: flow row i stays in cache while every candidate in the block uses it
+    for (int i = 0; i < problem.n; i++) {
+        const int* flow_row = problem.flow[i].data();
+        for (int k = 0; k < count; k++) {
+            const int* permutation = permutations[k]->data();
+            const int* dist_row = problem.distance[permutation[i]].data();
+            if (derived.sparse_flow) {
+                long long row = 0;
+                for (const auto& entry : derived.flow_rows[i]) {
+                    row += static_cast<long long>(entry.second) * dist_row[permutation[entry.first]];
+                }
+                sums[k] += row;
+            } else if (derived.narrow_rows) {
+                int row = 0;
+                for (int j = 0; j < problem.n; j++) row += flow_row[j] * dist_row[permutation[j]];
+                sums[k] += row;
+            } else {
+                long long row = 0;
+                for (int j = 0; j < problem.n; j++) row += static_cast<long long>(flow_row[j]) * dist_row[permutation[j]];
+                sums[k] += row;
+            }
+        }
+    }
+    for (int k = 0; k < count; k++) costs[k] = sums[k];
+}
+
+void evaluate_batch(const Problem& problem, const vector<const vector<int>*>& permutations, vector<long long>& costs, ThreadPool* pool) {
+    int count = static_cast<int>(permutations.size());
+    costs.resize(count);
+    int blocks = (count + BATCH_BLOCK - 1) / BATCH_BLOCK;
+    int threads = pool ? pool->threads : 1;
+    auto work = [&](int worker) {
+        for (int b = worker; b < blocks; b += threads) {
+            int begin = b * BATCH_BLOCK;
+            evaluate_block(problem, permutations.data() + begin, min(BATCH_BLOCK, count - begin), costs.data() + begin);
+        }
+    };
+    if (threads > 1 && blocks > 1) {
+        pool->run(work);
+    } else {
+        threads = 1;
+        work(0);
+    }
+}
+
+void evaluate_batch(const Problem& problem, const vector<vector<int>>& permutations, vector<long long>& costs, ThreadPool* pool) {
+    vector<const vector<int>*> pointers;
+    pointers.reserve(permutations.size());
+    for (const auto& permutation : permutations) pointers.push_back(&permutation);
+    evaluate_batch(problem, pointers, costs, pool);
+}
+
+ExactResult enumerate_layouts(const Problem& problem) {
+    int n = problem.n;
+    ExactResult result;
+    result.method = "enumeration";
+    vector<int> permutation(n);
+    iota(permutation.begin(), permutation.end(), 0);
+    long long cost = calculate_cost(problem, permutation);
+    result.permutation = permutation;
+    result.cost = cost;
+    result.nodes = 1;
+    // Heap's algorithm reaches every permutation from the previous one by a single swap,
+    // so each layout costs one O(n) delta instead of a full O(n^2) evaluation
+    vector<int> counter(n, 0);
+    int i = 1;
+    while (i < n) {
+        if (counter[i] < i) {
+            int other = (i % 2 == 0) ? 0 : counter[i];
+            cost += compute_swap_delta(problem, permutation, other, i);
+            swap(permutation[other], permutation[i]);
+            result.nodes++;
+            if (cost < result.cost) {
+                result.cost = cost;
+                result.permutation = permutation;
+            }
+            counter[i]++;
+            i = 1;
+        } else {
+            counter[i] = 0;
+            i++;
+        }
+    }
+    result.optimal = true;
+    return result;
+}
+
+ExactResult branch_and_bound(const Problem& problem, long long node_budget, chrono::steady_clock::time_point stop) {
+    int n = problem.n;
+    const Matrix& flow = problem.flow;
+    const Matrix& distance = problem.distance;
+    ExactResult result;
+    result.method = "branch and bound";
+
+    // a short Tabu Search gives an incumbent good enough to prune most of the tree
+    Wolf start(n);
+    start.fitness = calculate_cost(problem, start.permutation);
+    TabuMemory memory(n, 0.0);
+    apply_tabu_search(problem, start, 20 * n, max(1, n / 2), memory);
+    result.permutation = start.permutation;
+    result.cost = start.fitness;
+
+    // place heavily interacting facilities first, their placement decides most of the cost
+    vector<int> order(n);
+    iota(order.begin(), order.end(), 0);
+    vector<long long> mass(n, 0);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) mass[i] += llabs(static_cast<long long>(flow[i][j])) + llabs(static_cast<long long>(flow[j][i]));
+    }
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return mass[a] > mass[b]; });
+    // off-diagonal flows among the facilities still unplaced at each depth, ascending
+    vector<vector<long long>> open_flows(n + 1);
+    for (int depth = 0; depth <= n; depth++) {
+        for (int a = depth; a < n; a++) {
+            for (int b = depth; b < n; b++) {
+                if (a != b) open_flows[depth].push_back(flow[order[a]][order[b]]);
+            }
+        }
+        sort(open_flows[depth].begin(), open_flows[depth].end());
+    }
+
+    vector<int> permutation(n, -1);
+    vector<char> used(n, 0);
+    // linear[i * n + l]: cost between facility i placed at location l and the facilities placed so far
+    vector<long long> linear(static_cast<size_t>(n) * n, 0);
+    vector<long long> free_distances;
+    // lex-leader symmetry breaking: with the first facilities placed, an automorphism that keeps
+    // them in place and maps location l to a smaller one leads to an equivalent, smaller layout,
+    // so l is skipped. stabilizers[depth] holds the automorphisms fixing every placed location.
+    vector<vector<const vector<int>*>> stabilizers(n + 1);
+    for (const auto& symmetry : problem.derived->automorphisms) stabilizers[0].push_back(&symmetry);
+    bool exhausted = false;
+    function<void(int, long long)> descend = [&](int depth, long long cost) {
+        if (++result.nodes > node_budget || (result.nodes % 1024 == 0 && chrono::steady_clock::now() >= stop)) {
+            exhausted = true;
+            return;
+        }
+        if (depth == n) {
+            if (cost < result.cost) {
+                result.cost = cost;
+                result.permutation = permutation;
+            }
+            return;
+        }
+        // bound: every unplaced facility at its cheapest free location, plus the flows between
+        // unplaced facilities paired with the free distances in the cheapest possible order
+        long long bound = cost;
+        for (int a = depth; a < n; a++) {
+            int i = order[a];
+            long long cheapest = LLONG_MAX;
+            for (int l = 0; l < n; l++) {
+                if (!used[l]) cheapest = min(cheapest, linear[i * n + l] + static_cast<long long>(flow[i][i]) * distance[l][l]);
+            }
+            bound += cheapest;
+        }
+        free_distances.clear();
+        for (int l = 0; l < n; l++) {
+            if (used[l]) continue;
+            for (int m = 0; m < n; m++) {
+                if (m != l && !used[m]) free_distances.push_back(distance[l][m]);
+            }
+        }
+        sort(free_distances.rbegin(), free_distances.rend());
+        const vector<long long>& flows = open_flows[depth];
+        for (size_t k = 0; k < flows.size(); k++) bound += flows[k] * free_distances[k];
+        if (bound >= result.cost) return;
+
+        int i = order[depth];
+        vector<pair<long long, int>> choices;
+        for (int l = 0; l < n; l++) {
+            if (!used[l]) choices.push_back({linear[i * n + l] + static_cast<long long>(flow[i][i]) * distance[l][l], l});
+        }
+        sort(choices.begin(), choices.end());
+        for (const auto& choice : choices) {
+            int l = choice.second;
+            bool leader = true;
+            for (const vector<int>* symmetry : stabilizers[depth]) {
+                if ((*symmetry)[l] < l) {
+                    leader = false;
+                    break;
+                }
+            }
+            if (!leader) continue;
+            stabilizers[depth + 1].clear();
+            for (const vector<int>* symmetry : stabilizers[depth]) {
+                if ((*symmetry)[l] == l) stabilizers[depth + 1].push_back(symmetry);
+            }
+            permutation[i] = l;
+            used[l] = 1;
+            for (int a = depth + 1; a < n; a++) {
+                int j = order[a];
+                for (int m = 0; m < n; m++) {
+                    if (!used[m]) linear[j * n + m] += static_cast<long long>(flow[j][i]) * distance[m][l] + static_cast<long long>(flow[i][j]) * distance[l][m];
+                }
+            }
+            descend(depth + 1, cost + choice.first);
+            for (int a = depth + 1; a < n; a++) {
+                int j = order[a];
+                for (int m = 0; m < n; m++) {
+                    if (!used[m]) linear[j * n + m] -= static_cast<long long>(flow[j][i]) * distance[m][l] + static_cast<long long>(flow[i][j]) * distance[l][m];
+                }
+            }
+            used[l] = 0;
+            permutation[i] = -1;
+            if (exhausted) return;
+        }
+    };
+    descend(0, 0);
+    result.optimal = !exhausted;
+    return result;
+}
+
+bool solve_exactly(const Problem& problem, const Config& config, ExactResult& result, chrono::steady_clock::time_point deadline) {
+    // --top-k wants the layouts a search walks through, which the exact solvers do not keep
+    if (problem.n > config.exact_max_n || config.top_k > 0) return false;
+    auto start = chrono::steady_clock::now();
+    // branch and bound may not finish, so it gets at most half of the time, the rest is left for GWO + TS
+    deadline = min(deadline, deadline_from(start, config.time_limit));
+    auto stop = deadline == chrono::steady_clock::time_point::max() ? deadline : start + (deadline - start) / 2;
+    result = problem.n <= ENUMERATION_MAX_N ? enumerate_layouts(problem) : branch_and_bound(problem, config.exact_nodes, stop);
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result.optimal;
+}
+
+void print_exact(const ExactResult& result) {
+    print_layout(result.permutation, result.cost);
+    cout << "Proven optimal by " << result.method << " (" << result.nodes
+         << (result.method == "enumeration" ? " layouts" : " nodes") << ") in " << result.seconds << "s" << endl;
+}
+
+void print_layout(const vector<int>& permutation, long long cost) {
+    cout << "\n=== FINAL RESULTS ===" << endl;
+    cout << "Best cost found: " << cost << endl;
+    cout << "Best assignment:" << endl;
+    // numeric facility indices starting from 0
+    for (size_t i = 0; i < permutation.size(); i++) {
+        cout << "  Facility " << i << " -> Location " << permutation[i] << endl;
+    }
+}
+
+Wolf solve_standalone(const Problem& problem, const Config& config) {
+    Wolf best(problem.n);
+    ExactResult exact;
+    if (solve_exactly(problem, config, exact, deadline_from(chrono::steady_clock::now(), config.deadline))) {
+        best.permutation = exact.permutation;
+        best.fitness = exact.cost;
+        return best;
+    }
+    string summary;
+    if (config.multilevel > 0 && solve_multilevel(problem, config, best, summary)) return best;
+    GwoSearch search(problem, config);
+    search.deadline = deadline_from(chrono::steady_clock::now(), config.deadline);
+    init_search(search);
+    while (search_step(search)) {}
+    return search.alpha;
+}
+
+vector<int> cluster_locations(const Problem& problem, int clusters) {
+    int n = problem.n;
+    const Matrix& distance = problem.distance;
+    // Prim's minimum spanning tree over the symmetrized distances; removing its k - 1 longest
+    // edges gives the single-linkage clustering into k groups
+    vector<double> reach(n, HUGE_VAL);
+    vector<int> parent(n, -1);
+    vector<char> in_tree(n, 0);
+    vector<pair<double, int>> edges; //(length, child) of every tree edge
+    reach[0] = 0.0;
+    for (int step = 0; step < n; step++) {
+        int next = -1;
+        for (int a = 0; a < n; a++) {
+            if (!in_tree[a] && (next == -1 || reach[a] < reach[next])) next = a;
+        }
+        in_tree[next] = 1;
+        if (parent[next] >= 0) edges.push_back({reach[next], next});
+        for (int a = 0; a < n; a++) {
+            double length = (static_cast<double>(distance[next][a]) + distance[a][next]) / 2.0;
+            if (!in_tree[a] && length < reach[a]) {
+                reach[a] = length;
+                parent[a] = next;
+            }
+        }
+    }
+    sort(edges.rbegin(), edges.rend());
+    if (clusters < 0) {
+        // detect: cut above the widest gap between consecutive edge lengths, if the longer
+        // edge is at least twice the shorter; otherwise there is no cluster structure
+        clusters = 1;
+        double widest = 2.0;
+        for (size_t k = 0; k + 1 < edges.size() && static_cast<int>(k + 2) <= n / 2; k++) {
+            double ratio = edges[k].first / max(edges[k + 1].first, 1e-9);
+            if (ratio >= widest) {
+                widest = ratio;
+                clusters = static_cast<int>(k) + 2;
+            }
+        }
+    }
+    clusters = max(1, min(clusters, n));
+    vector<char> cut(n, 0);
+    for (int k = 0; k < clusters - 1; k++) cut[edges[k].second] = 1;
+    // label each location by walking up to the root of its part of the tree
+    vector<int> cluster(n, -1);
+    int labels = 0;
+    for (int a = 0; a < n; a++) {
+        vector<int> path;
+        int b = a;
+        while (cluster[b] == -1 && !cut[b] && parent[b] >= 0) {
+            path.push_back(b);
+            b = parent[b];
+        }
+        if (cluster[b] == -1) cluster[b] = labels++;
+        for (int c : path) cluster[c] = cluster[b];
+    }
+    return cluster;
+}
+
+vector<int> group_facilities(const Problem& problem, const vector<int>& sizes) {
+    int n = problem.n;
+    const Matrix& flow = problem.flow;
+    vector<int> group(n, -1);
+    vector<long long> affinity(n); //flow between each unassigned facility and the group being grown
+    // fill the largest groups first, each seeded with the facility that has the most flow left
+    vector<int> by_size(sizes.size());
+    iota(by_size.begin(), by_size.end(), 0);
+    stable_sort(by_size.begin(), by_size.end(), [&](int a, int b) { return sizes[a] > sizes[b]; });
+    for (int g : by_size) {
+        fill(affinity.begin(), affinity.end(), 0);
+        for (int i = 0; i < n; i++) {
+            if (group[i] != -1) continue;
+            for (int j = 0; j < n; j++) {
+                if (group[j] == -1 && j != i) affinity[i] += static_cast<long long>(flow[i][j]) + flow[j][i];
+            }
+        }
+        for (int member = 0; member < sizes[g]; member++) {
+            int pick = -1;
+            for (int i = 0; i < n; i++) {
+                if (group[i] == -1 && (pick == -1 || affinity[i] > affinity[pick])) pick = i;
+            }
+            group[pick] = g;
+            // from now on only flow into the growing group counts
+            if (member == 0) fill(affinity.begin(), affinity.end(), 0);
+            for (int i = 0; i < n; i++) affinity[i] += static_cast<long long>(flow[i][pick]) + flow[pick][i];
+        }
+    }
+    return group;
+}
+
+bool solve_decomposed(const Problem& problem, const Config& config, Wolf& result, string& summary) {
+    auto start = chrono::steady_clock::now();
+    int n = problem.n;
+    vector<int> cluster = cluster_locations(problem, config.clusters);
+    int count = *max_element(cluster.begin(), cluster.end()) + 1;
+    if (count < 2) return false;
+    vector<vector<int>> locations(count);
+    for (int l = 0; l < n; l++) locations[cluster[l]].push_back(l);
+    vector<int> sizes(count);
+    for (int c = 0; c < count; c++) sizes[c] = static_cast<int>(locations[c].size());
+    vector<int> group = group_facilities(problem, sizes);
+    vector<vector<int>> facilities(count);
+    for (int i = 0; i < n; i++) facilities[group[i]].push_back(i);
+
+    // place the groups on same-sized clusters so that heavy inter-group flows cross short
+    // inter-cluster distances: a small QAP between groups, enumerated when there are few
+    vector<int> placement(count);
+    iota(placement.begin(), placement.end(), 0);
+    if (count <= 8) {
+        vector<vector<double>> between(count, vector<double>(count, 0.0)), flows(count, vector<double>(count, 0.0));
+        for (int a = 0; a < n; a++) {
+            for (int b = 0; b < n; b++) {
+                between[cluster[a]][cluster[b]] += problem.distance[a][b];
+                flows[group[a]][group[b]] += problem.flow[a][b];
+            }
+        }
+        for (int c = 0; c < count; c++) {
+            for (int e = 0; e < count; e++) between[c][e] /= static_cast<double>(sizes[c]) * sizes[e];
+        }
+        vector<int> candidate = placement;
+        double best = HUGE_VAL;
+        do {
+            bool fits = true;
+            for (int g = 0; g < count && fits; g++) fits = sizes[candidate[g]] == sizes[g];
+            if (!fits) continue;
+            double cost = 0.0;
+            for (int g = 0; g < count; g++) {
+                for (int h = 0; h < count; h++) {
+                    if (g != h) cost += flows[g][h] * between[candidate[g]][candidate[h]];
+                }
+            }
+            if (cost < best) {
+                best = cost;
+                placement = candidate;
+            }
+        } while (next_permutation(candidate.begin(), candidate.end()));
+    }
+
+    // every group is an independent QAP on its cluster; they are solved in parallel, each
+    // with its own seed so the result does not depend on the thread count. Each thread solves
+    // its parts one after another, so the time left is split evenly between those rounds
+    int threads = min(config.threads, count);
+    int rounds = (count + threads - 1) / threads;
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    auto share = [&](double seconds) { return seconds > 0.0 ? max(seconds - elapsed, 1e-3) / rounds : 0.0; };
+    vector<vector<int>> parts(count);
+    auto solve_part = [&](int g) {
+        const vector<int>& members = facilities[g];
+        const vector<int>& sites = locations[placement[g]];
+        int size = static_cast<int>(members.size());
+        Matrix part_distance(size, vector<int>(size)), part_flow(size, vector<int>(size));
+        for (int a = 0; a < size; a++) {
+            for (int b = 0; b < size; b++) {
+                part_distance[a][b] = problem.distance[sites[a]][sites[b]];
+                part_flow[a][b] = problem.flow[members[a]][members[b]];
+            }
+        }
+        Config part_config = config;
+        part_config.threads = 1;
+        part_config.top_k = 0;
+        part_config.clusters = 0;
+        part_config.time_limit = share(config.time_limit);
+        part_config.deadline = share(config.deadline);
+        if (config.seed != 0) part_config.seed = config.seed + g + 1;
+        Problem part = make_problem(move(part_distance), move(part_flow));
+        parts[g] = solve_standalone(part, part_config).permutation;
+    };
+    if (threads > 1) {
+        ThreadPool pool(threads);
+        pool.run([&](int worker) {
+            for (int g = worker; g < count; g += threads) solve_part(g);
+        });
+    } else {
+        for (int g = 0; g < count; g++) solve_part(g);
+    }
+
+    // stitch the parts together and let a global Tabu Search repair the seams
+    result = Wolf(n);
+    for (int g = 0; g < count; g++) {
+        for (size_t a = 0; a < facilities[g].size(); a++) {
+            result.permutation[facilities[g][a]] = locations[placement[g]][parts[g][a]];
+        }
+    }
+    result.fitness = calculate_cost(problem, result.permutation);
+    long long stitched = result.fitness;
+    if (config.ts_iterations > 0) {
+        TabuMemory memory(n, config.freq_penalty, config.solution_tabu);
+        unique_ptr<ThreadPool> pool;
+        if (config.threads > 1) pool = make_unique<ThreadPool>(config.threads);
+        apply_tabu_search(problem, result, config.ts_iterations, config.tabu_tenure, memory, pool.get());
+    }
+    ostringstream text;
+    text << count << " clusters of sizes";
+    for (int size : sizes) text << " " << size;
+    text << ", stitched cost " << stitched << ", after global Tabu Search " << result.fitness;
+    summary = text.str();
+    return true;
+}
+
+vector<int> match_pairs(const Matrix& weight, bool heaviest, int& count) {
+    int n = static_cast<int>(weight.size());
+    auto edge = [&](int a, int b) { return static_cast<long long>(weight[a][b]) + weight[b][a]; };
+    auto prefer = [&](long long a, long long b) { return heaviest ? a > b : a < b; };
+    // visit nodes by their best edge, so the strongest edges are matched before their ends are taken
+    vector<long long> best(n);
+    for (int a = 0; a < n; a++) {
+        best[a] = heaviest ? LLONG_MIN : LLONG_MAX;
+        for (int b = 0; b < n; b++) {
+            if (b != a && prefer(edge(a, b), best[a])) best[a] = edge(a, b);
+        }
+    }
+    vector<int> order(n);
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return prefer(best[a], best[b]); });
+    vector<int> pair_of(n, -1);
+    count = 0;
+    for (int a : order) {
+        if (pair_of[a] != -1) continue;
+        int partner = -1;
+        for (int b = 0; b < n; b++) {
+            if (b != a && pair_of[b] == -1 && (partner == -1 || prefer(edge(a, b), edge(a, partner)))) partner = b;
+        }
+        pair_of[a] = count;
+        if (partner != -1) pair_of[partner] = count; //with odd n the last node stays alone
+        count++;
+    }
+    return pair_of;
+}
+
+Problem coarsen_problem(const Problem& problem, const vector<int>& facility_pair, const vector<int>& location_pair, int count) {
+    int n = problem.n;
+    vector<vector<long long>> flow(count, vector<long long>(count, 0));
+    vector<vector<long long>> distance(count, vector<long long>(count, 0));
+    vector<vector<long long>> pairs(count, vector<long long>(count, 0));
+    for (int a = 0; a < n; a++) {
+        for (int b = 0; b < n; b++) {
+            flow[facility_pair[a]][facility_pair[b]] += problem.flow[a][b];
+            if (a == b) continue; //a merged location's own distance is the one between its two halves
+            distance[location_pair[a]][location_pair[b]] += problem.distance[a][b];
+            pairs[location_pair[a]][location_pair[b]]++;
+        }
+    }
+    Matrix coarse_flow(count, vector<int>(count)), coarse_distance(count, vector<int>(count));
+    for (int g = 0; g < count; g++) {
+        for (int h = 0; h < count; h++) {
+            coarse_flow[g][h] = static_cast<int>(max<long long>(INT_MIN, min<long long>(INT_MAX, flow[g][h])));
+            coarse_distance[g][h] = pairs[g][h] == 0 ? 0 : static_cast<int>(llround(static_cast<double>(distance[g][h]) / pairs[g][h]));
+        }
+    }
+    return make_problem(move(coarse_distance), move(coarse_flow));
+}
+
+long long refine_nearby(const Problem& problem, Wolf& wolf, int neighbors) {
+    int n = problem.n;
+    neighbors = min(neighbors, n - 1);
+    vector<vector<int>> nearest(n);
+    vector<int> others(n);
+    for (int l = 0; l < n; l++) {
+        iota(others.begin(), others.end(), 0);
+        swap(others[l], others[n - 1]);
+        partial_sort(others.begin(), others.begin() + neighbors, others.end() - 1, [&](int a, int b) {
+            return make_pair(problem.distance[l][a], a) < make_pair(problem.distance[l][b], b);
+        });
+        nearest[l].assign(others.begin(), others.begin() + neighbors);
+    }
+    vector<int> facility_at(n);
+    for (int i = 0; i < n; i++) facility_at[wolf.permutation[i]] = i;
+    long long gained = 0;
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        for (int i = 0; i < n; i++) {
+            for (int l : nearest[wolf.permutation[i]]) {
+                int j = facility_at[l];
+                long long delta = compute_swap_delta(problem, wolf.permutation, i, j);
+                if (delta < 0) {
+                    facility_at[wolf.permutation[i]] = j;
+                    facility_at[l] = i;
+                    swap(wolf.permutation[i], wolf.permutation[j]);
+                    gained -= delta;
+                    improved = true;
+                    break; //i now sits elsewhere, so its neighbor list changed
+                }
+            }
+        }
+    }
+    wolf.fitness -= gained;
+    return gained;
+}
+
+bool solve_multilevel(const Problem& problem, const Config& config, Wolf& result, string& summary) {
+    if (problem.n <= config.multilevel) return false;
+    // coarsen by merging heavy-flow facility pairs and close location pairs until the
+    // instance is small enough for the regular solver
+    vector<unique_ptr<Problem>> coarse;
+    vector<vector<int>> facility_pairs, location_pairs;
+    const Problem* level = &problem;
+    while (level->n > config.multilevel) {
+        int facility_count = 0, location_count = 0;
+        facility_pairs.push_back(match_pairs(level->flow, true, facility_count));
+        location_pairs.push_back(match_pairs(level->distance, false, location_count));
+        coarse.push_back(make_unique<Problem>(coarsen_problem(*level, facility_pairs.back(), location_pairs.back(), facility_count)));
+        level = coarse.back().get();
+    }
+
+    Config coarse_config = config;
+    coarse_config.multilevel = 0;
+    coarse_config.clusters = 0;
+    coarse_config.top_k = 0;
+    Wolf current = solve_standalone(*level, coarse_config);
+    ostringstream text;
+    text << "levels";
+    for (auto it = coarse.rbegin(); it != coarse.rend(); ++it) text << " " << (*it)->n;
+    text << " " << problem.n << ", coarsest cost " << current.fitness;
+
+    // project each level's layout onto the next finer one: the members of a merged facility
+    // take the members of its merged location, and an odd node left over on either side
+    // takes whatever remains
+    for (int k = static_cast<int>(coarse.size()) - 1; k >= 0; k--) {
+        const Problem& fine = k == 0 ? problem : *coarse[k - 1];
+        int n = fine.n;
+        int count = coarse[k]->n;
+        vector<vector<int>> facilities(count), locations(count);
+        for (int a = 0; a < n; a++) {
+            facilities[facility_pairs[k][a]].push_back(a);
+            locations[location_pairs[k][a]].push_back(a);
+        }
+        Wolf projected(n);
+        vector<int> unplaced, free_locations;
+        for (int g = 0; g < count; g++) {
+            const vector<int>& sites = locations[current.permutation[g]];
+            for (size_t m = 0; m < facilities[g].size(); m++) {
+                if (m < sites.size()) projected.permutation[facilities[g][m]] = sites[m];
+                else unplaced.push_back(facilities[g][m]);
+            }
+            for (size_t m = facilities[g].size(); m < sites.size(); m++) free_locations.push_back(sites[m]);
+        }
+        for (size_t m = 0; m < unplaced.size(); m++) projected.permutation[unplaced[m]] = free_locations[m];
+        projected.fitness = calculate_cost(fine, projected.permutation);
+        refine_nearby(fine, projected, MULTILEVEL_NEIGHBORS);
+        if (n <= MULTILEVEL_TS_MAX_N && config.ts_iterations > 0) {
+            TabuMemory memory(n, config.freq_penalty, config.solution_tabu);
+            unique_ptr<ThreadPool> pool;
+            if (config.threads > 1) pool = make_unique<ThreadPool>(config.threads);
+            apply_tabu_search(fine, projected, config.ts_iterations, config.tabu_tenure, memory, pool.get());
+        }
+        current = move(projected);
+    }
+    text << ", final cost " << current.fitness;
+    summary = text.str();
+    result = move(current);
+    return true;
+}
+
+vector<int> lvp_decode(const vector<double>& position) {
+    int n = position.size();
+    vector<pair<double, int>> sorted_positions;
+
+    for (int i = 0; i < n; i++) {
+        sorted_positions.push_back({position[i], i});
+    }
+
+    sort(sorted_positions.begin(), sorted_positions.end(), greater<>());
+
+    vector<int> permutation(n);
+    for (int i = 0; i < n; i++) {
+        permutation[sorted_positions[i].second] = i;
+    }
+
+    return permutation;
+}
+
+vector<int> LvpDecoder::decode(const vector<double>& position) {
+    return lvp_decode(position);
+}
+
+void encode_position(Wolf& wolf) {
+    // hand the position's own values out again by rank: the facility at location 0 gets the
+    // largest value and so on, which keeps the value distribution the pack has converged to
+    int n = static_cast<int>(wolf.position.size());
+    vector<double> values = wolf.position;
+    sort(values.begin(), values.end(), greater<>());
+    // clamping leaves ties at the bounds; lvp_decode would break them by index, so the values are
+    // made strictly decreasing
+    for (int k = 1; k < n; k++) values[k] = min(values[k], values[k - 1] - 1e-9);
+    for (int i = 0; i < n; i++) wolf.position[i] = values[wolf.permutation[i]];
+}
+
+void learn(const Config& config, Wolf& wolf) {
+    // Baldwinian learning only lets the refined cost guide selection
+    if (config.lamarckian) encode_position(wolf);
+}
+
+long long FirstImprovementPolish::apply(const Problem& problem, Wolf& wolf, int looks) {
+    return polish_layout(problem, wolf, true, looks);
+}
+
+long long BestImprovementPolish::apply(const Problem& problem, Wolf& wolf, int looks) {
+    return polish_layout(problem, wolf, false, looks);
+}
+
+long long polish_layout(const Problem& problem, Wolf& wolf, bool first_improvement, int looks) {
+    int n = problem.n;
+    vector<int>& permutation = wolf.permutation;
+    // don't-look bits: a facility without an improving swap is not looked at again until a move
+    // changes its surroundings; the queue holds the facilities whose bit is clear
+    deque<int> active(n);
+    iota(active.begin(), active.end(), 0);
+    vector<char> queued(n, 1);
+    auto wake = [&](int k) {
+        if (!queued[k]) {
+            queued[k] = 1;
+            active.push_back(k);
+        }
+    };
+    // move cache: each facility resumes its scan at the partner of its last improving swap,
+    // where another improvement is most likely and low indices are not always favored
+    vector<int> resume(n, 0);
+    long long evaluated = 0;
+    long long budget = looks > 0 ? static_cast<long long>(looks) * n : LLONG_MAX;
+    for (long long scans = 0; !active.empty() && scans < budget; scans++) {
+        int i = active.front();
+        active.pop_front();
+        queued[i] = 0;
+        long long best = 0;
+        int partner = -1;
+        for (int step = 0; step < n; step++) {
+            int j = (resume[i] + step) % n;
+            if (j == i) continue;
+            long long delta = compute_swap_delta(problem, permutation, i, j);
+            evaluated++;
+            if (delta < best) {
+                best = delta;
+                partner = j;
+                if (first_improvement) break;
+            }
+        }
+        if (partner == -1) continue;
+        swap(permutation[i], permutation[partner]);
+        wolf.fitness += best;
+        resume[i] = partner;
+        resume[partner] = i;
+        wake(i);
+        wake(partner);
+        // the swap deltas that changed are those of the facilities exchanging flow with the moved
+        // pair, in either direction; waking exactly these keeps an empty queue a local optimum,
+        // and with sparse flows leaves most facilities asleep
+        const Matrix& flow = problem.flow;
+        for (int k = 0; k < n; k++) {
+            if (flow[i][k] != 0 || flow[k][i] != 0 || flow[partner][k] != 0 || flow[k][partner] != 0) wake(k);
+        }
+    }
+    return evaluated;
+}
+
+long long apply_tabu_search(const Problem& problem, Wolf& wolf, int ts_iterations, int tabu_tenure, TabuMemory& memory, ThreadPool* pool) {
+    TabuRun run(problem, wolf, ts_iterations, tabu_tenure, memory, pool);
+    while (run.advance(pool)) {}
+    return run.finish();
+}
+
+TabuRun::TabuRun(const Problem& p, Wolf& start, int iterations, int tenure, TabuMemory& m, ThreadPool* pool)
+    : problem(p), wolf(start), memory(m), ts_iterations(iterations), tabu_tenure(tenure),
+      tabu_count(static_cast<size_t>(p.n) * p.n, 0), current_solution(start.permutation), best_solution(start.permutation),
+      current_cost(start.fitness), best_cost(start.fitness), visited(m.solution_window + 1) {
+    long long& global_best = memory.global_best;  // Track global best across all TS calls
+    if (best_cost < global_best) {
+        global_best = best_cost;
+    }
+    sync_deltas(problem, memory, current_solution, pool);
+    best_deltas = memory.deltas;
+    if (memory.solution_window > 0) {
+        for (int f = 0; f < problem.n; f++) own_keys.push_back(zobrist_key(f, current_solution[f]));
+        current_hash = hash_permutation(current_solution);
+        visited.add(current_hash, 0);
+        recent.push_back(current_hash);
+    }
+}
+
+bool TabuRun::advance(ThreadPool* pool) {
+    if (stuck || iter >= ts_iterations) return false;
+    int n = problem.n;
+    int window = memory.solution_window;
+    long long& global_best = memory.global_best;
+    const vector<long long>& deltas = memory.deltas;
+    // rows are only split across threads when a neighborhood scan outweighs the hand-off; the
+    // pool can differ between calls, e.g. server slices with and without borrowed workers
+    int threads = (pool && n >= PARALLEL_SCAN_MIN_N) ? pool->threads : 1;
+    partial.assign(threads, MoveChoice());
+    partial_blocked.assign(threads, MoveChoice());
+    auto neighbor_hash = [&](int i, int j) {
+        return current_hash ^ own_keys[i] ^ own_keys[j] ^ zobrist_key(i, current_solution[j]) ^ zobrist_key(j, current_solution[i]);
+    };
+
+    // Diversify once a full tenure passes without improvement: moves into assignments the
+    // search has used often are penalized in proportion to how often they were used
+    bool diversify = memory.penalty > 0.0 && memory.recorded > 0 && since_improvement >= tabu_tenure;
+    double penalty_scale = diversify ? memory.penalty * static_cast<double>(llabs(current_cost)) / n / memory.recorded : 0.0;
+
+    // Explore 2-opt neighborhood; worker w scans rows w, w + threads, ... so row lengths balance out
+    auto scan = [&](int worker) {
+        MoveChoice best, blocked;
+        for (int i = worker; i < n - 1; i += threads) {
+            for (int j = i + 1; j < n; j++) {
+                // Cost of the neighbor obtained by swapping positions i and j
+                long long neighbor_cost = current_cost + deltas[i * n + j];
+
+                // Check if move is tabu
+                bool is_tabu = tabu_count[i * n + j] > 0;
+                //Accept move if not tabu or if it improves global best (aspiration criterion)
+                bool aspiration = neighbor_cost < global_best;
+                if (!is_tabu || aspiration) {
+                    double score = static_cast<double>(neighbor_cost);
+                    if (diversify && !aspiration) {
+                        score += penalty_scale * (memory.frequency[i * n + current_solution[j]] + memory.frequency[j * n + current_solution[i]]);
+                    }
+                    MoveChoice candidate{score, neighbor_cost, i, j};
+                    if (better_move(candidate, best)) {
+                        if (window > 0 && !aspiration && visited.find(neighbor_hash(i, j))) {
+                            if (better_move(candidate, blocked)) blocked = candidate;
+                        } else {
+                            best = candidate;
+                        }
+                    }
+                }
+            }
+        }
+        partial[worker] = best;
+        partial_blocked[worker] = blocked;
+    };
+    if (threads > 1) {
+        pool->run(scan);
+    } else {
+        scan(0);
+    }
+    // reduce by (score, i, j): the same move a serial scan picks, whatever the thread timing
+    MoveChoice chosen;
+    for (const auto& candidate : partial) {
+        if (better_move(candidate, chosen)) chosen = candidate;
+    }
+    long long best_neighbor_cost = chosen.cost;
+    int best_i = chosen.i, best_j = chosen.j;
+
+    evaluated += static_cast<long long>(n) * (n - 1) / 2;
+    // If no valid move found (all moves are tabu and don't satisfy aspiration), stop
+    if (best_i == -1) {
+        stuck = true;
+        return false;
+    }
+
+    if (window > 0) {
+        // every move better than the chosen one was seen by its worker, so the best skipped
+        // move is found whatever the thread count: if it beats the chosen move, the search
+        // would have cycled back to a solution it left cycle_length iterations ago
+        MoveChoice blocked;
+        for (const auto& candidate : partial_blocked) {
+            if (better_move(candidate, blocked)) blocked = candidate;
+        }
+        if (blocked.i != -1 && better_move(blocked, chosen)) {
+            int cycle_length = iter + 1 - visited.find(neighbor_hash(blocked.i, blocked.j))->visited;
+            memory.cycles_blocked++;
+            memory.cycle_length_sum += cycle_length;
+            memory.longest_cycle = max(memory.longest_cycle, cycle_length);
+        }
+        memory.window_moves++;
+        current_hash = neighbor_hash(best_i, best_j);
+    }
+
+    // Update current solution and the deltas of its neighbors
+    update_deltas(problem, memory, best_i, best_j, pool);
+    std::swap(current_solution[best_i], current_solution[best_j]);
+    current_cost = best_neighbor_cost;
+    if (window > 0) {
+        own_keys[best_i] = zobrist_key(best_i, current_solution[best_i]);
+        own_keys[best_j] = zobrist_key(best_j, current_solution[best_j]);
+        visited.add(current_hash, iter + 1);
+        recent.push_back(current_hash);
+        if (static_cast<int>(recent.size()) > window) {
+            visited.remove(recent.front());
+            recent.pop_front();
+        }
+    }
+
+    // Record the new assignments in the long-term memory
+    for (int f = 0; f < n; f++) memory.frequency[f * n + current_solution[f]]++;
+    memory.recorded++;
+
+    // Update best solution
+    if (current_cost < best_cost) {
+        best_solution = current_solution;
+        best_deltas = deltas;
+        best_cost = current_cost;
+        since_improvement = 0;
+        if (best_cost < global_best) {
+            global_best = best_cost;
+        }
+    } else {
+        since_improvement++;
+    }
+
+    // Add move to tabu list
+    tabu_list.push_back({best_i, best_j});
+    tabu_count[best_i * n + best_j]++;
+    if (static_cast<int>(tabu_list.size()) > tabu_tenure) {
+        tabu_count[tabu_list.front().first * n + tabu_list.front().second]--;
+        tabu_list.pop_front();
+    }
+    iter++;
+    return true;
+}
+
+long long TabuRun::finish() {
+    // Update wolf with best solution found
+    wolf.permutation = best_solution;
+    wolf.fitness = best_cost;
+    memory.delta_layout = best_solution;
+    memory.deltas = move(best_deltas);
+    return evaluated;
+}
+
+void build_deltas(const Problem& problem, TabuMemory& memory, const vector<int>& permutation, ThreadPool* pool) {
+    int n = problem.n;
+    memory.delta_layout = permutation;
+    memory.deltas.assign(static_cast<size_t>(n) * n, 0);
+    int threads = (pool && n >= PARALLEL_SCAN_MIN_N) ? pool->threads : 1;
+    auto rows = [&](int worker) {
+        for (int i = worker; i < n - 1; i += threads) {
+            for (int j = i + 1; j < n; j++) memory.deltas[i * n + j] = compute_swap_delta(problem, permutation, i, j);
+        }
+    };
+    if (threads > 1) {
+        pool->run(rows);
+    } else {
+        rows(0);
+    }
+}
+
+void update_deltas(const Problem& problem, TabuMemory& memory, int r, int s, ThreadPool* pool) {
+    int n = problem.n;
+    const Matrix& a = problem.flow;
+    const Matrix& b = problem.distance;
+    vector<int>& p = memory.delta_layout;
+    swap(p[r], p[s]);
+    // Taillard's update: a swap (u, v) disjoint from (r, s) only changes by the interaction of the
+    // two moves, which takes O(1); the swaps that involve r or s are recomputed in O(n)
+    int pr = p[r], ps = p[s];
+    int threads = (pool && n >= PARALLEL_SCAN_MIN_N) ? pool->threads : 1;
+    auto rows = [&](int worker) {
+        for (int u = worker; u < n - 1; u += threads) {
+            long long* row = memory.deltas.data() + static_cast<size_t>(u) * n;
+            int pu = p[u];
+            for (int v = u + 1; v < n; v++) {
+                if (u == r || u == s || v == r || v == s) {
+                    row[v] = compute_swap_delta(problem, p, u, v);
+                    continue;
+                }
+                int pv = p[v];
+                // widen every entry first: the four-term sums overflow int for large matrices
+                long long flow_out = static_cast<long long>(a[r][u]) - a[r][v] + a[s][v] - a[s][u];
+                long long dist_out = static_cast<long long>(b[ps][pu]) - b[ps][pv] + b[pr][pv] - b[pr][pu];
+                long long flow_in = static_cast<long long>(a[u][r]) - a[v][r] + a[v][s] - a[u][s];
+                long long dist_in = static_cast<long long>(b[pu][ps]) - b[pv][ps] + b[pv][pr] - b[pu][pr];
+                row[v] += flow_out * dist_out + flow_in * dist_in;
+            }
+        }
+    };
+    if (threads > 1) {
+        pool->run(rows);
+    } else {
+        rows(0);
+    }
+}
+
+void sync_deltas(const Problem& problem, TabuMemory& memory, const vector<int>& permutation, ThreadPool* pool) {
+    int n = problem.n;
+    vector<int>& layout = memory.delta_layout;
+    int differing = 0;
+    if (!layout.empty()) {
+        for (int i = 0; i < n; i++) differing += layout[i] != permutation[i];
+    }
+    // a replayed swap costs about 8 / n of a rebuild
+    if (layout.empty() || differing * 8 > n) {
+        build_deltas(problem, memory, permutation, pool);
+        return;
+    }
+    if (differing == 0) return;
+    vector<int> facility_at(n);
+    for (int i = 0; i < n; i++) facility_at[layout[i]] = i;
+    for (int i = 0; i < n; i++) {
+        if (layout[i] == permutation[i]) continue;
+        int j = facility_at[permutation[i]];
+        facility_at[layout[i]] = j;
+        facility_at[layout[j]] = i;
+        update_deltas(problem, memory, i, j, pool);
+    }
+}
+
+vector<Wolf> path_relink(const Problem& problem, const Wolf& source, const vector<int>& target, int keep) {
+    RelinkRun run(problem, source, target, keep);
+    while (run.advance()) {}
+    return move(run.best);
+}
+
+RelinkRun::RelinkRun(const Problem& p, const Wolf& source, const vector<int>& target_layout, int count)
+    : problem(p), position(source.position), target(target_layout), current(source.permutation), facility_at(p.n),
+      cost(source.fitness), keep(count) {
+    for (int i = 0; i < problem.n; i++) facility_at[current[i]] = i;
+}
+
+bool RelinkRun::advance() {
+    int n = problem.n;
+    // among the swaps that move one more facility to its target location, take the cheapest
+    long long best_delta = LLONG_MAX;
+    int best_i = -1, best_j = -1;
+    for (int i = 0; i < n; i++) {
+        if (current[i] == target[i]) continue;
+        int j = facility_at[target[i]];
+        long long delta = compute_swap_delta(problem, current, i, j);
+        if (delta < best_delta) {
+            best_delta = delta;
+            best_i = i;
+            best_j = j;
+        }
+    }
+    if (best_i == -1) return false;
+    std::swap(current[best_i], current[best_j]);
+    facility_at[current[best_i]] = best_i;
+    facility_at[current[best_j]] = best_j;
+    cost += best_delta;
+    if (current == target) return false;
+
+    // keep the `keep` cheapest intermediates; each step agrees with target on more facilities, so they are distinct
+    if (static_cast<int>(best.size()) < keep || cost < best.back().fitness) {
+        Wolf wolf(n);
+        wolf.position = position;
+        wolf.permutation = current;
+        wolf.fitness = cost;
+        if (static_cast<int>(best.size()) >= keep) best.pop_back();
+        auto pos = upper_bound(best.begin(), best.end(), cost,
+                               [](long long c, const Wolf& w) { return c < w.fitness; });
+        best.insert(pos, move(wolf));
+    }
+    return true;
+}
+
+SolutionSet::SolutionSet(int capacity) {
+    size_t size = 2;
+    while (size < 2 * static_cast<size_t>(capacity)) size <<= 1;
+    slots.resize(size);
+    mask = size - 1;
+}
+
+const SolutionSet::Slot* SolutionSet::find(uint64_t key) const {
+    // zobrist hashes are well mixed, so their low bits serve as the home slot
+    for (size_t i = key & mask; slots[i].count > 0; i = (i + 1) & mask) {
+        if (slots[i].key == key) return &slots[i];
+    }
+    return nullptr;
+}
+
+void SolutionSet::add(uint64_t key, int iteration) {
+    size_t i = key & mask;
+    while (slots[i].count > 0 && slots[i].key != key) i = (i + 1) & mask;
+    slots[i].key = key;
+    slots[i].count++;
+    slots[i].visited = iteration;
+}
+
+void SolutionSet::remove(uint64_t key) {
+    size_t i = key & mask;
+    while (slots[i].key != key || slots[i].count == 0) i = (i + 1) & mask;
+    if (--slots[i].count > 0) return;
+    // backward shift: move later entries of the probe run into the hole unless their home slot
+    // lies cyclically in (hole, entry], so every remaining key stays reachable without tombstones
+    for (size_t j = (i + 1) & mask; slots[j].count > 0; j = (j + 1) & mask) {
+        size_t home = slots[j].key & mask;
+        bool stays = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+        if (!stays) {
+            slots[i] = slots[j];
+            i = j;
+        }
+    }
+    slots[i] = SolutionSet::Slot();
+}
+
+uint64_t zobrist_key(int facility, int location) {
+    // splitmix64 of the (facility, location) pair, so no table has to be stored per problem size
+    uint64_t x = (static_cast<uint64_t>(facility) << 32) ^ static_cast<uint64_t>(location);
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t hash_permutation(const vector<int>& permutation) {
+    uint64_t hash = 0;
+    for (int i = 0; i < static_cast<int>(permutation.size()); i++) {
+        hash ^= zobrist_key(i, permutation[i]);
+    }
+    return hash;
+}
+
+vector<vector<int>> find_automorphisms(const Matrix& distance) {
+    int n = static_cast<int>(distance.size());
+    vector<vector<int>> found;
+    // a location can only map onto one with the same diagonal entry and the same sorted row and column
+    vector<uint64_t> color(n);
+    for (int a = 0; a < n; a++) {
+        vector<int> row = distance[a], column(n);
+        for (int b = 0; b < n; b++) column[b] = distance[b][a];
+        sort(row.begin(), row.end());
+        sort(column.begin(), column.end());
+        color[a] = hash_matrix({{distance[a][a]}, row, column});
+    }
+    // backtrack over images of locations 0, 1, ...; every partial map must preserve the distances
+    // among the locations mapped so far. The step budget guards against highly regular matrices.
+    vector<int> image(n, -1);
+    vector<char> taken(n, 0);
+    long long steps = 0, budget = 20000LL * n;
+    function<bool(int)> extend = [&](int a) {
+        if (a == n) {
+            bool identity = true;
+            for (int b = 0; b < n && identity; b++) identity = image[b] == b;
+            if (!identity) found.push_back(image);
+            return found.size() < AUTOMORPHISM_LIMIT;
+        }
+        for (int c = 0; c < n; c++) {
+            if (taken[c] || color[c] != color[a]) continue;
+            if (++steps > budget) return false;
+            bool consistent = distance[a][a] == distance[c][c];
+            for (int b = 0; b < a && consistent; b++) {
+                consistent = distance[a][b] == distance[c][image[b]] && distance[b][a] == distance[image[b]][c];
+            }
+            if (!consistent) continue;
+            image[a] = c;
+            taken[c] = 1;
+            bool more = extend(a + 1);
+            taken[c] = 0;
+            image[a] = -1;
+            if (!more) return false;
+        }
+        return true;
+    };
+    extend(0);
+    return found;
+}
+
+vector<int> canonical_layout(const vector<int>& permutation, const vector<vector<int>>& automorphisms) {
+    vector<int> best = permutation;
+    vector<int> candidate(permutation.size());
+    for (const auto& symmetry : automorphisms) {
+        for (size_t i = 0; i < permutation.size(); i++) candidate[i] = symmetry[permutation[i]];
+        if (candidate < best) best = candidate;
+    }
+    return best;
+}
+
+uint64_t layout_hash(const vector<int>& permutation, const vector<vector<int>>* automorphisms) {
+    if (!automorphisms || automorphisms->empty()) return hash_permutation(permutation);
+    return hash_permutation(canonical_layout(permutation, *automorphisms));
+}
+
+bool elite_insert(EliteArchive& archive, const Wolf& wolf) {
+    if (archive.capacity <= 0) return false;
+    bool full = static_cast<int>(archive.entries.size()) >= archive.capacity;
+    if (full && wolf.fitness >= archive.entries.back().cost) return false;
+    uint64_t hash = layout_hash(wolf.permutation, archive.automorphisms);
+    if (archive.hashes.count(hash)) return false;
+
+    // find the closest entry; a near-duplicate only survives if it is the better of the two
+    int closest = -1;
+    int closest_distance = INT_MAX;
+    for (int k = 0; k < static_cast<int>(archive.entries.size()); k++) {
+        const vector<int>& other = archive.entries[k].permutation;
+        int distance = 0;
+        for (size_t i = 0; i < other.size() && distance < closest_distance; i++) {
+            if (other[i] != wolf.permutation[i]) distance++;
+        }
+        if (distance < closest_distance) {
+            closest = k;
+            closest_distance = distance;
+        }
+    }
+    if (closest >= 0 && closest_distance < archive.min_distance) {
+        if (wolf.fitness >= archive.entries[closest].cost) return false;
+        archive.hashes.erase(archive.entries[closest].hash);
+        archive.entries.erase(archive.entries.begin() + closest);
+    } else if (full) {
+        archive.hashes.erase(archive.entries.back().hash);
+        archive.entries.pop_back();
+    }
+
+    EliteEntry entry{wolf.permutation, wolf.position, wolf.fitness, hash};
+    auto pos = upper_bound(archive.entries.begin(), archive.entries.end(), entry.cost,
+                           [](long long cost, const EliteEntry& e) { return cost < e.cost; });
+    archive.entries.insert(pos, move(entry));
+    archive.hashes.insert(hash);
+    return true;
+}
+
+Wolf elite_wolf(const EliteEntry& entry) {
+    Wolf wolf(static_cast<int>(entry.permutation.size()));
+    wolf.position = entry.position;
+    wolf.permutation = entry.permutation;
+    wolf.fitness = entry.cost;
+    return wolf;
+}
+
+void topk_offer(TopKCollector& top, const vector<int>& permutation, long long cost) {
+    if (top.k <= 0) return;
+    bool full = static_cast<int>(top.heap.size()) >= top.k;
+    if (full && cost > top.heap.front().first) return;
+    uint64_t hash = layout_hash(permutation, top.automorphisms);
+    pair<long long, uint64_t> key{cost, hash};
+    if (full && key >= top.heap.front()) return;
+    if (top.solutions.count(hash)) return;
+    if (full) {
+        pop_heap(top.heap.begin(), top.heap.end());
+        top.solutions.erase(top.heap.back().second);
+        top.heap.pop_back();
+    }
+    top.heap.push_back(key);
+    push_heap(top.heap.begin(), top.heap.end());
+    top.solutions.emplace(hash, permutation);
+}
+
+void print_top_k(const TopKCollector& top) {
+    vector<pair<long long, uint64_t>> ranked = top.heap;
+    sort(ranked.begin(), ranked.end());
+    cout << "\n=== TOP " << ranked.size() << " LAYOUTS ===" << endl;
+    for (size_t k = 0; k < ranked.size(); k++) {
+        cout << "  #" << (k + 1) << " cost " << ranked[k].first << ":";
+        for (int loc : top.solutions.at(ranked[k].second)) cout << " " << loc;
+        cout << endl;
+    }
+    if (ranked.size() < 2) return;
+
+    // number of facilities placed differently between each pair of layouts
+    cout << "Pairwise differences (facilities assigned to different locations):" << endl;
+    cout << "      ";
+    for (size_t b = 0; b < ranked.size(); b++) cout << " " << setw(4) << ("#" + to_string(b + 1));
+    cout << endl;
+    for (size_t a = 0; a < ranked.size(); a++) {
+        const vector<int>& pa = top.solutions.at(ranked[a].second);
+        cout << "  #" << left << setw(3) << (a + 1) << right;
+        for (size_t b = 0; b < ranked.size(); b++) {
+            const vector<int>& pb = top.solutions.at(ranked[b].second);
+            int diff = 0;
+            for (size_t i = 0; i < pa.size(); i++) {
+                if (pa[i] != pb[i]) diff++;
+            }
+            cout << " " << setw(4) << diff;
+        }
+        cout << endl;
+    }
+}
+
+uint64_t hash_text(const string& text) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t hash_matrix(const Matrix& matrix) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (const auto& row : matrix) {
+        for (int value : row) {
+            hash ^= static_cast<uint32_t>(value);
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash ^ matrix.size();
+}
+
+shared_ptr<const Problem> cache_instance(InstanceCache& cache, const string& text, bool& hit) {
+    uint64_t key = hash_text(text);
+    {
+        lock_guard<mutex> guard(cache.lock);
+        auto it = cache.problems.find(key);
+        if (it != cache.problems.end() && it->second.text == text) {
+            cache.text_hits++;
+            hit = true;
+            return it->second.problem;
+        }
+    }
+    hit = false;
+    // parse outside the lock so other workers keep getting hits meanwhile
+    Matrix distance_matrix, flow_matrix;
+    istringstream in(text);
+    read_matrices(in, distance_matrix, flow_matrix);
+    uint64_t distance_hash = hash_matrix(distance_matrix);
+    uint64_t flow_hash = hash_matrix(flow_matrix);
+    uint64_t pair_hash = distance_hash * 31 + flow_hash;
+
+    shared_ptr<const Matrix> distance, flow;
+    shared_ptr<const ProblemDerived> derived;
+    {
+        lock_guard<mutex> guard(cache.lock);
+        auto share = [&](Matrix& matrix, uint64_t hash) {
+            auto it = cache.matrices.find(hash);
+            if (it != cache.matrices.end()) {
+                auto existing = it->second.lock();
+                if (existing && *existing == matrix) {
+                    cache.matrix_hits++;
+                    return existing;
+                }
+            }
+            auto created = make_shared<const Matrix>(move(matrix));
+            cache.matrices[hash] = created;
+            return created;
+        };
+        distance = share(distance_matrix, distance_hash);
+        flow = share(flow_matrix, flow_hash);
+        auto it = cache.derived.find(pair_hash);
+        if (it != cache.derived.end() && it->second.distance.lock() == distance && it->second.flow.lock() == flow) {
+            derived = it->second.derived.lock();
+            if (derived) cache.derived_hits++;
+        }
+    }
+    if (!derived) derived = derive_problem(*distance, *flow);
+    auto problem = make_shared<const Problem>(distance, flow, derived);
+
+    lock_guard<mutex> guard(cache.lock);
+    cache.loads++;
+    cache.derived[pair_hash] = CachedDerived{distance, flow, derived};
+    auto inserted = cache.problems.emplace(key, CachedProblem{text, problem});
+    if (!inserted.second) {
+        // another worker loaded the same text first, or a different text with the same hash
+        // holds the slot and this problem is used uncached
+        const CachedProblem& existing = inserted.first->second;
+        return existing.text == text ? existing.problem : problem;
+    }
+    cache.order.push_back(key);
+    while (cache.order.size() > cache.capacity) {
+        cache.problems.erase(cache.order.front());
+        cache.order.pop_front();
+        // drop entries whose matrices are no longer used by anyone
+        for (auto m = cache.matrices.begin(); m != cache.matrices.end();) {
+            m = m->second.expired() ? cache.matrices.erase(m) : next(m);
+        }
+        for (auto d = cache.derived.begin(); d != cache.derived.end();) {
+            d = d->second.derived.expired() ? cache.derived.erase(d) : next(d);
+        }
+    }
+    return problem;
+}
+
+string encode_frame(const string& payload) {
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    string frame(4, '\0');
+    for (int b = 0; b < 4; b++) frame[b] = static_cast<char>((size >> (24 - 8 * b)) & 0xff);
+    return frame + payload;
+}
+
+bool write_frame(int fd, const string& payload) {
+    string frame = encode_frame(payload);
+    size_t sent = 0;
+    while (sent < frame.size()) {
+        ssize_t w = send(fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        sent += static_cast<size_t>(w);
+    }
+    return true;
+}
+
+bool read_frame(int fd, string& payload) {
+    auto read_exact = [fd](char* data, size_t size) {
+        size_t got = 0;
+        while (got < size) {
+            ssize_t r = recv(fd, data + got, size - got, 0);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            got += static_cast<size_t>(r);
+        }
+        return true;
+    };
+    unsigned char header[4];
+    if (!read_exact(reinterpret_cast<char*>(header), 4)) return false;
+    uint32_t size = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) | (uint32_t(header[2]) << 8) | header[3];
+    if (size > (1u << 28)) return false; // refuse absurd frames instead of allocating them
+    payload.assign(size, '\0');
+    return size == 0 || read_exact(&payload[0], size);
+}
+
+void wake_server(ServerState& state) {
+    // the pipe is non-blocking; when it is full a wake-up is already on its way
+    char byte = 0;
+    ssize_t written = write(state.wake_pipe[1], &byte, 1);
+    (void)written;
+}
+
+bool post_frames(ServerState& state, Connection& connection, const vector<string>& payloads) {
+    {
+        lock_guard<mutex> guard(state.lock);
+        if (connection.closed) return false;
+        if (payloads.empty()) return true;
+        for (const auto& payload : payloads) connection.outgoing += encode_frame(payload);
+    }
+    wake_server(state);
+    return true;
+}
+
+bool flush_connection(ServerState& state, Connection& connection) {
+    lock_guard<mutex> guard(state.lock);
+    size_t sent = 0;
+    while (sent < connection.outgoing.size()) {
+        ssize_t w = send(connection.fd, connection.outgoing.data() + sent, connection.outgoing.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (w <= 0) {
+            connection.closed = true;
+            connection.outgoing.clear();
+            return false;
+        }
+        sent += static_cast<size_t>(w);
+    }
+    connection.outgoing.erase(0, sent);
+    return true;
+}
+
+bool take_frame(string& buffer, string& payload) {
+    if (buffer.size() < 4) return false;
+    const unsigned char* header = reinterpret_cast<const unsigned char*>(buffer.data());
+    uint32_t size = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) | (uint32_t(header[2]) << 8) | header[3];
+    if (size > (1u << 28)) throw runtime_error("request frame too large");
+    if (buffer.size() < 4 + static_cast<size_t>(size)) return false;
+    payload = buffer.substr(4, size);
+    buffer.erase(0, 4 + static_cast<size_t>(size));
+    return true;
+}
+
+map<string, string> parse_json_object(const string& text) {
+    map<string, string> fields;
+    size_t i = 0;
+    auto skip_space = [&]() { while (i < text.size() && isspace(static_cast<unsigned char>(text[i]))) i++; };
+    auto fail = [&](const string& what) { throw invalid_argument("Malformed JSON request: " + what); };
+    auto parse_string = [&]() {
+        string out;
+        i++; // opening quote
+        while (i < text.size() && text[i] != '"') {
+            char c = text[i++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (i >= text.size()) fail("unterminated escape");
+            char e = text[i++];
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    if (i + 4 > text.size()) fail("short \\u escape");
+                    int code = stoi(text.substr(i, 4), nullptr, 16);
+                    out += code < 128 ? static_cast<char>(code) : '?'; // instances and options are ASCII
+                    i += 4;
+                    break;
+                }
+                default: out += e; break; // \" \\ \/
+            }
+        }
+        if (i >= text.size()) fail("unterminated string");
+        i++; // closing quote
+        return out;
+    };
+
+    skip_space();
+    if (i >= text.size() || text[i] != '{') fail("expected an object");
+    i++;
+    while (true) {
+        skip_space();
+        if (i < text.size() && text[i] == '}') break;
+        if (i >= text.size() || text[i] != '"') fail("expected a key");
+        string key = parse_string();
+        skip_space();
+        if (i >= text.size() || text[i] != ':') fail("expected ':' after " + key);
+        i++;
+        skip_space();
+        if (i >= text.size()) fail("missing value for " + key);
+        string value;
+        if (text[i] == '"') {
+            value = parse_string();
+        } else if (text[i] == '[') {
+            // arrays (permutations) are returned raw, e.g. "[0,2,1,3]"
+            size_t end = text.find(']', i);
+            if (end == string::npos) fail("unterminated array");
+            value = text.substr(i, end + 1 - i);
+            i = end + 1;
+        } else {
+            size_t end = text.find_first_of(",}", i);
+            if (end == string::npos) fail("unterminated value");
+            value = text.substr(i, end - i);
+            while (!value.empty() && isspace(static_cast<unsigned char>(value.back()))) value.pop_back();
+            i = end;
+        }
+        fields[key] = value;
+        skip_space();
+        if (i < text.size() && text[i] == ',') {
+            i++;
+            continue;
+        }
+        if (i < text.size() && text[i] == '}') break;
+        fail("expected ',' or '}'");
+    }
+    return fields;
+}
+
+string json_string(const string& text) {
+    string out = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            case '\r': out += "\\r"; break;
+            default: out += c; break;
+        }
+    }
+    return out + "\"";
+}
+
+string json_permutation(const vector<int>& permutation) {
+    string out = "[";
+    for (size_t i = 0; i < permutation.size(); i++) {
+        if (i > 0) out += ",";
+        out += to_string(permutation[i]);
+    }
+    return out + "]";
+}
+
+string json_improvement(const SearchEvent& event) {
+    ostringstream message;
+    message << "{\"event\":\"improvement\",\"cost\":" << event.cost << ",\"iteration\":" << event.iteration
+            << ",\"seconds\":" << event.seconds << ",\"evaluations\":" << event.evaluations
+            << ",\"permutation\":" << json_permutation(event.permutation) << "}";
+    return message.str();
+}
+
+chrono::steady_clock::time_point deadline_from(chrono::steady_clock::time_point start, double seconds) {
+    if (seconds <= 0.0) return chrono::steady_clock::time_point::max();
+    return start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+}
+
+double record_deadline(DeadlineStats& stats, chrono::steady_clock::time_point deadline) {
+    if (deadline == chrono::steady_clock::time_point::max()) return 0.0;
+    double late = chrono::duration<double>(chrono::steady_clock::now() - deadline).count();
+    lock_guard<mutex> guard(stats.lock);
+    stats.solves++;
+    if (late <= 0.0) return 0.0;
+    stats.missed++;
+    stats.worst_lateness = max(stats.worst_lateness, late);
+    return late;
+}
+
+string deadline_summary(DeadlineStats& stats) {
+    lock_guard<mutex> guard(stats.lock);
+    if (stats.solves == 0) return "";
+    ostringstream summary;
+    summary << ", deadlines: " << stats.missed << " of " << stats.solves << " missed";
+    if (stats.missed > 0) summary << " (worst by " << stats.worst_lateness << "s)";
+    return summary.str();
+}
+
+bool receive_requests(ServerState& state, const Config& defaults, Connection& connection) {
+    char buffer[65536];
+    while (true) {
+        ssize_t r = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (r > 0) {
+            connection.incoming.append(buffer, static_cast<size_t>(r));
+            continue;
+        }
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return false; // closed by the client, or failed
+    }
+    try {
+        // one request at a time per connection; later ones wait in the buffer
+        string request;
+        while (!connection.busy && take_frame(connection.incoming, request)) {
+            if (!queue_request(state, defaults, connection, request)) return false;
+        }
+    } catch (const exception&) {
+        return false;
+    }
+    return true;
+}
+
+string option_from_json(const string& value) {
+    if (value == "true") return "1";
+    if (value == "false") return "0";
+    return value;
+}
+
+bool queue_request(ServerState& state, const Config& defaults, Connection& connection, const string& request) {
+    try {
+        map<string, string> fields = parse_json_object(request);
+        if (fields.count("command") && fields.at("command") == "shutdown") {
+            state.stopping = true;
+            state.ready.notify_all();
+            return post_frames(state, connection, {"{\"event\":\"shutdown\"}"});
+        }
+        auto task = make_unique<SolveTask>();
+        task->config = defaults;
+        for (const auto& field : fields) {
+            if (field.first == "instance" || field.first == "input_file") continue;
+            string option = "--" + field.first;
+            replace(option.begin(), option.end(), '_', '-');
+            if (!apply_option(task->config, option, option_from_json(field.second))) {
+                throw invalid_argument("Unknown request field: " + field.first);
+            }
+        }
+        if (task->config.clusters != 0 || task->config.multilevel != 0) {
+            throw invalid_argument("clusters and multilevel are not supported by the server; use --batch or a direct run");
+        }
+        // a request may not ask for more search threads than the server has workers
+        task->config.threads = min(task->config.threads, defaults.workers);
+        task->connection = state.connections.at(connection.fd);
+        task->fields = move(fields);
+        task->deadline = deadline_from(chrono::steady_clock::now(), task->config.deadline);
+        connection.busy = true;
+        schedule_task(state, move(task));
+        return true;
+    } catch (const exception& e) {
+        return post_frames(state, connection, {"{\"event\":\"error\",\"message\":" + json_string(e.what()) + "}"});
+    }
+}
+
+void schedule_task(ServerState& state, unique_ptr<SolveTask> task) {
+    lock_guard<mutex> guard(state.lock);
+    TaskKey key(-task->config.priority, task->deadline, state.next_sequence++);
+    state.runnable.emplace(key, move(task));
+    state.ready.notify_one();
+}
+
+void start_task(ServerState& state, const Config& defaults, SolveTask& task) {
+    if (task.fields.count("instance")) {
+        task.problem = cache_instance(state.cache, task.fields.at("instance"), task.cached);
+    } else if (task.fields.count("input_file")) {
+        ifstream file(task.fields.at("input_file"));
+        if (!file.is_open()) throw runtime_error("Cannot open file: " + task.fields.at("input_file"));
+        stringstream text;
+        text << file.rdbuf();
+        task.problem = cache_instance(state.cache, text.str(), task.cached);
+    } else {
+        throw invalid_argument("Request needs an \"instance\" or an \"input_file\"");
+    }
+    // clusters and multilevel from a preset stay unused here: the server solves one search per task
+    apply_preset(task.config, task.problem->n);
+
+    // a slice must stay short, so branch and bound gets one slice (solve_exactly spends half of
+    // what it is given) before the task falls back to GWO + TS
+    auto exact_deadline = min(task.deadline, deadline_from(chrono::steady_clock::now(), 2.0 * defaults.slice_ms / 1000.0));
+    if (solve_exactly(*task.problem, task.config, task.exact, exact_deadline)) return;
+    apply_auto_budget(task.config, *task.problem);
+    // the search owns no helper threads; run_slice lends it the idle workers' share one slice at
+    // a time, and task.config.threads only says how many it may use
+    Config search_config = task.config;
+    search_config.threads = 1;
+    task.search = make_unique<GwoSearch>(*task.problem, search_config);
+    GwoSearch& search = *task.search;
+    search.deadline = task.deadline;
+    search.progress = [&task](const SearchEvent& event) {
+        if (event.improved) task.outbox.push_back(json_improvement(event));
+    };
+    init_search(search);
+    SearchEvent initial;
+    initial.improved = true;
+    initial.cost = search.alpha.fitness;
+    initial.permutation = search.alpha.permutation;
+    initial.seconds = search_seconds(search);
+    initial.evaluations = search.evaluations;
+    task.outbox.push_back(json_improvement(initial));
+}
+
+bool run_slice(ServerState& state, const Config& defaults, SolveTask& task, int borrowed) {
+    bool running = true;
+    if (!task.search) {
+        start_task(state, defaults, task);
+        running = !task.exact.optimal;
+    } else {
+        // borrowed helpers only live for this slice, and the slice ends early once another request
+        // needs a worker, so the process never runs more search threads than there are workers and
+        // queued or preempted solves hold no threads at all
+        GwoSearch& search = *task.search;
+        if (borrowed > 0) search.pool = make_unique<ThreadPool>(1 + borrowed);
+        function<bool()> workers_wanted;
+        if (borrowed > 0) {
+            workers_wanted = [&]() {
+                lock_guard<mutex> guard(state.lock);
+                return state.busy + static_cast<int>(state.runnable.size()) + state.lent > defaults.workers;
+            };
+        }
+        // a search can yield between two Tabu Search moves or relinking swaps, so a slice
+        // overruns by at most one of those or one pack update and evaluation
+        auto until = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double, milli>(defaults.slice_ms));
+        running = search_until(search, until, workers_wanted);
+        search.pool.reset();
+    }
+    // the slice's improvements go to the accept loop, which sends them as fast as the client reads
+    bool connected = post_frames(state, *task.connection, task.outbox);
+    task.outbox.clear();
+    return running && connected;
+}
+
+void finish_task(ServerState& state, SolveTask& task, const string& error) {
+    bool open;
+    {
+        lock_guard<mutex> guard(state.lock);
+        open = !task.connection->closed;
+    }
+    if (open && !error.empty()) {
+        post_frames(state, *task.connection, {"{\"event\":\"error\",\"message\":" + json_string(error) + "}"});
+    } else if (open && task.exact.optimal) {
+        ostringstream result;
+        result << "{\"event\":\"result\",\"n\":" << task.problem->n << ",\"cost\":" << task.exact.cost
+               << ",\"iterations\":0,\"seconds\":" << task.exact.seconds << ",\"evaluations\":" << task.exact.nodes
+               << ",\"cached\":" << (task.cached ? "true" : "false") << ",\"optimal\":true"
+               << ",\"permutation\":" << json_permutation(task.exact.permutation);
+        if (task.deadline != chrono::steady_clock::time_point::max()) {
+            result << ",\"deadline_missed\":" << (record_deadline(state.deadlines, task.deadline) > 0.0 ? "true" : "false");
+        }
+        result << "}";
+        post_frames(state, *task.connection, {result.str()});
+    } else if (open) {
+        const GwoSearch& search = *task.search;
+        ostringstream result;
+        result << "{\"event\":\"result\",\"n\":" << task.problem->n << ",\"cost\":" << search.alpha.fitness
+               << ",\"iterations\":" << search.iteration << ",\"seconds\":" << search_seconds(search)
+               << ",\"evaluations\":" << search.evaluations
+               << ",\"cached\":" << (task.cached ? "true" : "false") << ",\"optimal\":false"
+               << ",\"permutation\":" << json_permutation(search.alpha.permutation);
+        if (task.deadline != chrono::steady_clock::time_point::max()) {
+            result << ",\"deadline_missed\":" << (record_deadline(state.deadlines, task.deadline) > 0.0 ? "true" : "false");
+        }
+        result << "}";
+        post_frames(state, *task.connection, {result.str()});
+    }
+    {
+        lock_guard<mutex> guard(state.lock);
+        state.returned.push_back(task.connection->fd);
+    }
+    wake_server(state);
+}
+
+int run_server(const Config& config) {
+    ServerState state;
+    state.cache.capacity = static_cast<size_t>(config.cache_size);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (config.serve_socket.size() >= sizeof(addr.sun_path)) {
+        throw invalid_argument("Socket path too long: " + config.serve_socket);
+    }
+    strcpy(addr.sun_path, config.serve_socket.c_str());
+    state.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (state.listen_fd < 0) throw runtime_error(string("socket() failed: ") + strerror(errno));
+    unlink(config.serve_socket.c_str()); // remove a stale socket left by a previous server
+    if (bind(state.listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(state.listen_fd, 64) < 0) {
+        string reason = strerror(errno);
+        close(state.listen_fd);
+        throw runtime_error("Cannot listen on " + config.serve_socket + ": " + reason);
+    }
+    if (pipe(state.wake_pipe) < 0) {
+        string reason = strerror(errno);
+        close(state.listen_fd);
+        throw runtime_error("pipe() failed: " + reason);
+    }
+    for (int fd : state.wake_pipe) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    cout << "Serving on " << config.serve_socket << " with " << config.workers << " workers" << endl;
+
+    // the workers are started once and stay warm between requests; each takes the most urgent
+    // task, runs one slice of it and requeues it, so a new high-priority request preempts
+    // running ones at their next slice boundary
+    vector<thread> workers;
+    for (int w = 0; w < config.workers; w++) {
+        workers.emplace_back([&state, &config]() {
+            while (true) {
+                unique_ptr<SolveTask> task;
+                int borrowed = 0;
+                {
+                    unique_lock<mutex> guard(state.lock);
+                    state.ready.wait(guard, [&]() { return state.stopping || !state.runnable.empty(); });
+                    if (state.runnable.empty()) return;
+                    task = move(state.runnable.begin()->second);
+                    state.runnable.erase(state.runnable.begin());
+                    state.busy++;
+                    // search helpers only come from workers that have nothing to run; they count
+                    // as lent until the slice ends. A solve gets up to its threads - 1 of them, and
+                    // a large solve in the second half of its deadline gets all of them
+                    int spare = config.workers - state.busy - static_cast<int>(state.runnable.size()) - state.lent;
+                    int wanted = task->config.threads;
+                    if (task->problem && task->problem->n >= PARALLEL_SCAN_MIN_N && task->search &&
+                        task->deadline != chrono::steady_clock::time_point::max() &&
+                        chrono::steady_clock::now() >= task->search->start + (task->deadline - task->search->start) / 2) {
+                        wanted = config.workers;
+                    }
+                    if (task->search && spare > 0 && wanted > 1) {
+                        borrowed = min(wanted - 1, spare);
+                        state.lent += borrowed;
+                    }
+                }
+                string error;
+                bool running = false;
+                try {
+                    running = run_slice(state, config, *task, borrowed);
+                } catch (const exception& e) {
+                    error = e.what();
+                }
+                if (borrowed > 0) {
+                    lock_guard<mutex> guard(state.lock);
+                    state.lent -= borrowed;
+                }
+                if (running) {
+                    {
+                        lock_guard<mutex> guard(state.lock);
+                        state.busy--;
+                    }
+                    schedule_task(state, move(task));
+                } else {
+                    finish_task(state, *task, error);
+                    lock_guard<mutex> guard(state.lock);
+                    state.busy--;
+                }
+            }
+        });
+    }
+
+    // connections without a request in progress are watched for input; whatever arrives is read
+    // without blocking and a request is queued once its whole frame is in. Output posted by the
+    // workers is sent whenever a connection can take it. After a shutdown request no new requests
+    // are read, but queued ones are finished and their answers get a second to go out.
+    auto drop = [&state](int fd) {
+        close(fd);
+        state.connections.erase(fd);
+    };
+    auto drain_until = chrono::steady_clock::time_point::max();
+    while (true) {
+        vector<pollfd> watched = {{state.listen_fd, static_cast<short>(state.stopping ? 0 : POLLIN), 0}, {state.wake_pipe[0], POLLIN, 0}};
+        bool requests_running = false;
+        bool output_pending = false;
+        {
+            lock_guard<mutex> guard(state.lock);
+            for (const auto& entry : state.connections) {
+                const Connection& connection = *entry.second;
+                requests_running = requests_running || connection.busy;
+                output_pending = output_pending || !connection.outgoing.empty();
+                short events = 0;
+                if (!connection.busy && !state.stopping) events |= POLLIN;
+                if (!connection.outgoing.empty()) events |= POLLOUT;
+                if (events) watched.push_back({entry.first, events, 0});
+            }
+        }
+        if (state.stopping && !requests_running) {
+            if (!output_pending) break;
+            if (drain_until == chrono::steady_clock::time_point::max()) drain_until = chrono::steady_clock::now() + chrono::seconds(1);
+            if (chrono::steady_clock::now() >= drain_until) break;
+        }
+        if (poll(watched.data(), watched.size(), state.stopping ? 100 : -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (size_t k = 2; k < watched.size(); k++) {
+            if (!watched[k].revents) continue;
+            Connection& connection = *state.connections.at(watched[k].fd);
+            bool open = true;
+            if (watched[k].events & POLLOUT) open = flush_connection(state, connection);
+            if (open && (watched[k].events & POLLIN)) open = receive_requests(state, config, connection);
+            if (!open) {
+                // a busy connection is dropped once its worker hands it back
+                lock_guard<mutex> guard(state.lock);
+                connection.closed = true;
+                connection.outgoing.clear();
+            }
+            if (!open && !connection.busy) drop(watched[k].fd);
+        }
+        if (watched[1].revents) {
+            char buffer[64];
+            while (read(state.wake_pipe[0], buffer, sizeof(buffer)) > 0) {}
+            vector<int> returned;
+            {
+                lock_guard<mutex> guard(state.lock);
+                returned.swap(state.returned);
+            }
+            for (int fd : returned) {
+                Connection& connection = *state.connections.at(fd);
+                connection.busy = false;
+                bool closed;
+                {
+                    lock_guard<mutex> guard(state.lock);
+                    closed = connection.closed;
+                }
+                // a request that arrived right behind the previous one is already buffered
+                if (closed || (!state.stopping && !receive_requests(state, config, connection))) drop(fd);
+            }
+        }
+        if (watched[0].revents) {
+            int fd = accept(state.listen_fd, nullptr, nullptr);
+            if (fd >= 0) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                state.connections[fd] = make_shared<Connection>();
+                state.connections[fd]->fd = fd;
+            }
+        }
+    }
+
+    state.stopping = true;
+    state.ready.notify_all();
+    for (auto& worker : workers) worker.join();
+    for (const auto& entry : state.connections) close(entry.first);
+    for (int fd : state.wake_pipe) close(fd);
+    close(state.listen_fd);
+    unlink(config.serve_socket.c_str());
+    cout << "Server stopped: " << state.cache.loads << " instances loaded, " << state.cache.text_hits << " cache hits, "
+         << state.cache.matrix_hits << " shared matrices, " << state.cache.derived_hits << " shared preprocessing"
+         << deadline_summary(state.deadlines) << endl;
+    return 0;
+}
+
+int run_client(const Config& config) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (config.client_socket.size() >= sizeof(addr.sun_path)) {
+        throw invalid_argument("Socket path too long: " + config.client_socket);
+    }
+    strcpy(addr.sun_path, config.client_socket.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        string reason = strerror(errno);
+        if (fd >= 0) close(fd);
+        throw runtime_error("Cannot connect to " + config.client_socket + ": " + reason);
+    }
+
+    // the instance is sent inline, every other explicit option is forwarded as a request field
+    string request;
+    if (config.shutdown_server) {
+        request = "{\"command\":\"shutdown\"}";
+    } else {
+        ifstream file(config.input_file);
+        if (!file.is_open()) {
+            close(fd);
+            throw runtime_error("Cannot open file: " + config.input_file);
+        }
+        stringstream text;
+        text << file.rdbuf();
+        request = "{\"instance\":" + json_string(text.str());
+        for (const auto& option : config.explicit_options) {
+            if (option.first == "--input-file") continue;
+            string key = option.first.substr(2);
+            replace(key.begin(), key.end(), '-', '_');
+            request += "," + json_string(key) + ":" + json_string(option.second);
+        }
+        request += "}";
+    }
+    if (!write_frame(fd, request)) {
+        close(fd);
+        throw runtime_error("Lost connection to " + config.client_socket);
+    }
+
+    string reply;
+    int status = 1;
+    while (read_frame(fd, reply)) {
+        map<string, string> event = parse_json_object(reply);
+        const string& kind = event["event"];
+        if (kind == "improvement") {
+            cout << "Iteration " << event["iteration"] << ": Best cost = " << event["cost"] << endl;
+            continue;
+        }
+        if (kind == "result") {
+            string permutation = event["permutation"];
+            replace(permutation.begin(), permutation.end(), ',', ' ');
+            istringstream locations(permutation.substr(1, permutation.size() - 2));
+            cout << "\n=== FINAL RESULTS ===" << endl;
+            cout << "Best cost found: " << event["cost"] << endl;
+            cout << "Best assignment:" << endl;
+            int location, facility = 0;
+            while (locations >> location) {
+                cout << "  Facility " << facility++ << " -> Location " << location << endl;
+            }
+            cout << "Solved in " << event["seconds"] << "s, " << event["iterations"] << " iterations"
+                 << (event["optimal"] == "true" ? " (proven optimal)" : "")
+                 << (event["cached"] == "true" ? " (cached instance)" : "") << endl;
+            status = 0;
+        } else if (kind == "shutdown") {
+            cout << "Server is shutting down" << endl;
+            status = 0;
+        } else {
+            cerr << "Error: " << event["message"] << endl;
+        }
+        break;
+    }
+    close(fd);
+    return status;
+}
+
+int run_batch(const Config& config) {
+    ifstream list(config.batch_file);
+    if (!list.is_open()) {
+        throw runtime_error("Cannot open file: " + config.batch_file);
+    }
+    // one request per line, written like command line options; '#' starts a comment
+    vector<string> lines;
+    string line;
+    while (getline(list, line)) {
+        size_t hash = line.find('#');
+        if (hash != string::npos) line.erase(hash);
+        if (line.find_first_not_of(" \t\r") != string::npos) lines.push_back(line);
+    }
+
+    // every request is parsed up front so the workers can take them by priority, then by
+    // earliest deadline; deadlines count from the start of the batch
+    auto batch_start = chrono::steady_clock::now();
+    vector<Config> requests(lines.size(), config);
+    vector<string> errors(lines.size());
+    for (size_t k = 0; k < lines.size(); k++) {
+        try {
+            istringstream tokens(lines[k]);
+            string option, value;
+            while (tokens >> option) {
+                if (option == "--auto") {
+                    apply_option(requests[k], option, "1");
+                    continue;
+                }
+                if (!(tokens >> value) || !apply_option(requests[k], option, value)) {
+                    throw invalid_argument("Unknown or incomplete option: " + option);
+                }
+            }
+        } catch (const exception& e) {
+            errors[k] = e.what();
+        }
+    }
+    vector<chrono::steady_clock::time_point> deadlines(lines.size());
+    vector<size_t> order(lines.size());
+    for (size_t k = 0; k < lines.size(); k++) {
+        deadlines[k] = deadline_from(batch_start, requests[k].deadline);
+        order[k] = k;
+    }
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return make_tuple(-requests[a].priority, deadlines[a]) < make_tuple(-requests[b].priority, deadlines[b]);
+    });
+
+    InstanceCache cache;
+    cache.capacity = static_cast<size_t>(config.cache_size);
+    DeadlineStats deadline_stats;
+    vector<string> reports(lines.size());
+    atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t position = next++; position < lines.size(); position = next++) {
+            size_t k = order[position];
+            Config request = requests[k];
+            ostringstream report;
+            report << "#" << (k + 1) << " ";
+            try {
+                if (!errors[k].empty()) throw invalid_argument(errors[k]);
+                ifstream file(request.input_file);
+                if (!file.is_open()) throw runtime_error("Cannot open file: " + request.input_file);
+                stringstream text;
+                text << file.rdbuf();
+                bool hit = false;
+                shared_ptr<const Problem> problem = cache_instance(cache, text.str(), hit);
+                apply_preset(request, problem->n);
+                ExactResult exact;
+                long long cost;
+                double seconds;
+                vector<int> permutation;
+                Wolf decomposed(problem->n);
+                string summary;
+                auto start = chrono::steady_clock::now();
+                bool optimal = solve_exactly(*problem, request, exact, deadlines[k]);
+                // the kernel timings behind --auto are only worth taking once a search is going to run
+                if (!optimal) apply_auto_budget(request, *problem);
+                if (optimal) {
+                    cost = exact.cost;
+                    seconds = exact.seconds;
+                    permutation = exact.permutation;
+                } else if ((request.clusters != 0 && solve_decomposed(*problem, request, decomposed, summary)) ||
+                           (request.multilevel > 0 && solve_multilevel(*problem, request, decomposed, summary))) {
+                    cost = decomposed.fitness;
+                    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                    permutation = decomposed.permutation;
+                } else {
+                    GwoSearch search(*problem, request);
+                    search.deadline = deadlines[k];
+                    init_search(search);
+                    while (search_step(search)) {}
+                    cost = search.alpha.fitness;
+                    seconds = search_seconds(search);
+                    permutation = search.alpha.permutation;
+                }
+                double late = record_deadline(deadline_stats, deadlines[k]);
+                report << request.input_file << " n=" << problem->n << " cost=" << cost
+                       << " seconds=" << seconds << (exact.optimal ? " (optimal)" : "") << (hit ? " (cached)" : "");
+                if (late > 0.0) report << " (deadline missed by " << late << "s)";
+                report << "\n   ";
+                for (int loc : permutation) report << " " << loc;
+            } catch (const exception& e) {
+                report << "error: " << e.what();
+            }
+            reports[k] = report.str();
+        }
+    };
+    vector<thread> pool;
+    for (int w = 0; w < config.workers; w++) pool.emplace_back(worker);
+    for (auto& t : pool) t.join();
+
+    for (const auto& report : reports) cout << report << endl;
+    cout << "Batch finished: " << cache.loads << " instances loaded, " << cache.text_hits << " cache hits, "
+         << cache.matrix_hits << " shared matrices, " << cache.derived_hits << " shared preprocessing"
+         << deadline_summary(deadline_stats) << endl;
+    return 0;
+}
+
+bool apply_option(Config& config, const string& option, const string& value) {
+    if (option == "--input-file") {
+        config.input_file = value;
+    } else if (option == "--pack-size") {
+        config.pack_size = stoi(value);
+        if (config.pack_size < 3) {
+            throw invalid_argument("Pack size must be at least 3 (needed for alpha/beta/delta)");
+        }
+    } else if (option == "--max-iterations") {
+        config.max_iterations = stoi(value);
+        if (config.max_iterations < 1) {
+            throw invalid_argument("Max iterations must be positive");
+        }
+    } else if (option == "--ts-iterations") {
+        config.ts_iterations = stoi(value);
+        if (config.ts_iterations < 0) {
+            throw invalid_argument("TS iterations must be >= 0 (use 0 to disable Tabu Search)");
+        }
+    } else if (option == "--tabu-tenure") {
+        config.tabu_tenure = stoi(value);
+        if (config.tabu_tenure < 1) {
+            throw invalid_argument("Tabu tenure must be positive");
+        }
+    } else if (option == "--ts-every") {
+        config.ts_every = stoi(value);
+        if (config.ts_every < 1) {
+            throw invalid_argument("ts-every must be >= 1");
+        }
+    } else if (option == "--jitter") {
+        config.jitter = stod(value);
+        if (config.jitter < 0.0) {
+            throw invalid_argument("jitter must be >= 0");
+        }
+    } else if (option == "--elite-size") {
+        config.elite_size = stoi(value);
+        if (config.elite_size < 0) {
+            throw invalid_argument("elite-size must be >= 0 (use 0 to disable the archive)");
+        }
+    } else if (option == "--elite-distance") {
+        config.elite_distance = stoi(value);
+        if (config.elite_distance < 0) {
+            throw invalid_argument("elite-distance must be >= 0");
+        }
+    } else if (option == "--top-k") {
+        config.top_k = stoi(value);
+        if (config.top_k < 0) {
+            throw invalid_argument("top-k must be >= 0");
+        }
+    } else if (option == "--pr-every") {
+        config.pr_every = stoi(value);
+        if (config.pr_every < 0) {
+            throw invalid_argument("pr-every must be >= 0 (use 0 to disable path relinking)");
+        }
+    } else if (option == "--pr-pairs") {
+        config.pr_pairs = stoi(value);
+        if (config.pr_pairs < 1) {
+            throw invalid_argument("pr-pairs must be positive");
+        }
+    } else if (option == "--pr-ts-iterations") {
+        config.pr_ts_iterations = stoi(value);
+        if (config.pr_ts_iterations < 0) {
+            throw invalid_argument("pr-ts-iterations must be >= 0");
+        }
+    } else if (option == "--freq-penalty") {
+        config.freq_penalty = stod(value);
+        if (config.freq_penalty < 0.0) {
+            throw invalid_argument("freq-penalty must be >= 0 (use 0 to disable)");
+        }
+    } else if (option == "--threads") {
+        config.threads = stoi(value);
+        if (config.threads < 1) {
+            throw invalid_argument("threads must be positive");
+        }
+    } else if (option == "--seed") {
+        config.seed = stoull(value);
+    } else if (option == "--time-limit") {
+        config.time_limit = stod(value);
+        if (config.time_limit < 0.0) {
+            throw invalid_argument("time-limit must be >= 0 (use 0 for no limit)");
+        }
+    } else if (option == "--exact-max-n") {
+        config.exact_max_n = stoi(value);
+        if (config.exact_max_n < 0) {
+            throw invalid_argument("exact-max-n must be >= 0 (use 0 to always run GWO + Tabu Search)");
+        }
+    } else if (option == "--exact-nodes") {
+        config.exact_nodes = stoll(value);
+        if (config.exact_nodes < 1) {
+            throw invalid_argument("exact-nodes must be positive");
+        }
+    } else if (option == "--clusters") {
+        config.clusters = value == "auto" ? -1 : stoi(value);
+        if (config.clusters < -1 || config.clusters == 1) {
+            throw invalid_argument("clusters must be auto, 0 (off) or at least 2");
+        }
+    } else if (option == "--multilevel") {
+        config.multilevel = stoi(value);
+        if (config.multilevel < 0 || config.multilevel == 1) {
+            throw invalid_argument("multilevel must be 0 (off) or at least 2");
+        }
+    } else if (option == "--priority") {
+        config.priority = stoi(value);
+    } else if (option == "--deadline") {
+        config.deadline = stod(value);
+        if (config.deadline < 0.0) {
+            throw invalid_argument("deadline must be >= 0 (use 0 for none)");
+        }
+    } else if (option == "--polish") {
+        if (value != "off" && value != "first" && value != "best") {
+            throw invalid_argument("polish must be off, first or best");
+        }
+        config.polish = value;
+    } else if (option == "--polish-looks") {
+        config.polish_looks = stoi(value);
+        if (config.polish_looks < 0) {
+            throw invalid_argument("polish-looks must be >= 0 (use 0 to polish to a local optimum)");
+        }
+    } else if (option == "--opposition") {
+        config.opposition = stoi(value);
+        if (config.opposition < 0) {
+            throw invalid_argument("opposition must be >= 0 (use 0 to disable)");
+        }
+    } else if (option == "--a-schedule") {
+        if (value != "linear" && value != "quadratic") {
+            throw invalid_argument("a-schedule must be linear or quadratic");
+        }
+        config.a_schedule = value;
+    } else if (option == "--coefficients") {
+        if (value != "uniform" && value != "logistic" && value != "tent") {
+            throw invalid_argument("coefficients must be uniform, logistic or tent");
+        }
+        config.coefficients = value;
+    } else if (option == "--steps") {
+        if (value != "gwo" && value != "levy") {
+            throw invalid_argument("steps must be gwo or levy");
+        }
+        config.steps = value;
+    } else if (option == "--target") {
+        config.target = stoll(value);
+    } else if (option == "--solution-tabu") {
+        config.solution_tabu = stoi(value);
+        if (config.solution_tabu < 0) {
+            throw invalid_argument("solution-tabu must be >= 0 (use 0 to disable)");
+        }
+    } else if (option == "--learning") {
+        if (value != "lamarckian" && value != "baldwinian") {
+            throw invalid_argument("learning must be lamarckian or baldwinian");
+        }
+        config.lamarckian = value == "lamarckian";
+    } else if (option == "--elite-restart") {
+        config.elite_restart = stoi(value);
+        if (config.elite_restart < 0) {
+            throw invalid_argument("elite-restart must be >= 0 (use 0 to disable restarts)");
+        }
+    } else if (option == "--auto") {
+        if (value != "0" && value != "1") throw invalid_argument("auto must be 0 or 1");
+        config.auto_budget = value == "1";
+    } else if (option == "--preset") {
+        if (none_of(PRESETS.begin(), PRESETS.end(), [&](const PresetEntry& entry) { return entry.name == value; })) {
+            throw invalid_argument("Unknown preset: " + value + " (use fast, balanced, thorough or large-n)");
+        }
+        config.preset = value;
+    } else {
+        return false;
+    }
+    config.pinned.insert(option);
+    return true;
+}
+
+void load_config_file(Config& config, const string& path) {
+    ifstream file(path);
+    if (!file.is_open()) throw runtime_error("Cannot open config file: " + path);
+    stringstream text;
+    text << file.rdbuf();
+    string content = text.str();
+    vector<pair<string, string>> entries;
+    size_t first = content.find_first_not_of(" \t\r\n");
+    if (first != string::npos && content[first] == '{') {
+        for (const auto& field : parse_json_object(content)) entries.push_back({field.first, option_from_json(field.second)});
+    } else {
+        // key = value per line, # starts a comment
+        istringstream lines(content);
+        string line;
+        while (getline(lines, line)) {
+            line = line.substr(0, line.find('#'));
+            size_t equals = line.find('=');
+            auto trim = [](const string& part) {
+                size_t begin = part.find_first_not_of(" \t\r");
+                if (begin == string::npos) return string();
+                return part.substr(begin, part.find_last_not_of(" \t\r") + 1 - begin);
+            };
+            if (trim(line).empty()) continue;
+            if (equals == string::npos) throw invalid_argument("Config line without '=': " + trim(line));
+            entries.push_back({trim(line.substr(0, equals)), trim(line.substr(equals + 1))});
+        }
+    }
+    for (const auto& entry : entries) {
+        // keys are option names with or without the leading dashes, e.g. pack-size or pack_size
+        string option = entry.first;
+        replace(option.begin(), option.end(), '_', '-');
+        if (option.compare(0, 2, "--") != 0) option = "--" + option;
+        if (config.pinned.count(option)) continue; //the command line wins
+        if (!apply_option(config, option, entry.second)) {
+            throw invalid_argument("Unknown config key in " + path + ": " + entry.first);
+        }
+        config.explicit_options.push_back({option, entry.second});
+    }
+}
+
+KernelSpeed measure_kernels(const Problem& problem, int tabu_tenure) {
+    // a millisecond or so of each kernel on a random layout of this instance, so the
+    // measurement covers its size, density and matrix symmetry
+    mt19937 gen(12345);
+    vector<int> permutation(problem.n);
+    iota(permutation.begin(), permutation.end(), 0);
+    shuffle(permutation.begin(), permutation.end(), gen);
+    uniform_int_distribution<int> facility(0, problem.n - 1);
+    vector<pair<int, int>> swaps(64);
+    for (auto& swap_pair : swaps) swap_pair = {facility(gen), facility(gen)};
+    KernelSpeed speed;
+    long long sink = calculate_cost(problem, permutation); //warm up the caches first
+    // the fastest of three runs of about a millisecond, which filters out most scheduling noise
+    auto time_rounds = [&](const function<int()>& round) {
+        double fastest = HUGE_VAL;
+        for (int run = 0; run < 3; run++) {
+            auto start = chrono::steady_clock::now();
+            int calls = 0;
+            double elapsed = 0.0;
+            while (elapsed < 1e-3) {
+                calls += round();
+                elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            }
+            fastest = min(fastest, elapsed / calls);
+        }
+        return fastest;
+    };
+    speed.delta_seconds = time_rounds([&]() {
+        for (const auto& swap_pair : swaps) sink += compute_swap_delta(problem, permutation, swap_pair.first, swap_pair.second);
+        return static_cast<int>(swaps.size());
+    });
+    speed.cost_seconds = time_rounds([&]() {
+        for (int k = 0; k < 8; k++) sink += calculate_cost(problem, permutation);
+        return 8;
+    });
+    // a rebuild is n^2 / 2 swap deltas; Tabu Search iterations are timed on a delta matrix that
+    // is marked current for the start layout, so the timing leaves the rebuild out (the moves
+    // chosen from the zero deltas do not matter, the work per iteration is the same)
+    speed.rebuild_seconds = problem.n * (problem.n - 1) / 2.0 * speed.delta_seconds;
+    int iterations = speed.rebuild_seconds < 2e-3 ? min(tabu_tenure, 16) + 1 : 2;
+    TabuMemory memory(problem.n, 0.0);
+    speed.scan_seconds = time_rounds([&]() {
+        Wolf wolf(problem.n);
+        wolf.permutation = permutation;
+        wolf.fitness = 0;
+        memory.delta_layout = permutation;
+        memory.deltas.assign(static_cast<size_t>(problem.n) * problem.n, 0);
+        sink += apply_tabu_search(problem, wolf, iterations, tabu_tenure, memory);
+        return iterations;
+    });
+    volatile long long keep = sink; //the volatile store keeps the timed calls from being optimized away
+    (void)keep;
+    return speed;
+}
+
+string apply_auto_budget(Config& config, const Problem& problem) {
+    if (!config.auto_budget) return "";
+    int n = problem.n;
+    // without a time limit, plan for a budget that grows with the instance: 0.2s for tiny
+    // layouts, about 5s at n = 100, at most a minute
+    double budget = config.time_limit > 0.0 ? config.time_limit : min(60.0, 0.2 + n * n / 2000.0);
+    // options set here are pinned by apply_option too, so decide on what was pinned before
+    const set<string> given = config.pinned;
+    auto set = [&](const string& option, long long value) {
+        if (!given.count(option)) apply_option(config, option, to_string(value));
+    };
+    auto clamp_to = [](double value, double low, double high) { return max(low, min(high, value)); };
+
+    set("--pack-size", static_cast<long long>(clamp_to(n / 2.0, 10, 40)));
+    set("--tabu-tenure", static_cast<long long>(clamp_to(n / 4.0, 5, 30)));
+    set("--ts-iterations", static_cast<long long>(clamp_to(2.0 * n, 20, 500)));
+    KernelSpeed speed = measure_kernels(problem, config.tabu_tenure);
+    // one GWO iteration decodes and costs the pack, then runs ts_iterations full swap
+    // neighborhoods every ts_every iterations; the scans split across threads from PARALLEL_SCAN_MIN_N
+    double scan_threads = n >= PARALLEL_SCAN_MIN_N ? 1.0 + 0.8 * (config.threads - 1) : 1.0;
+    double scan = speed.scan_seconds / scan_threads;
+    double rebuild = speed.rebuild_seconds / scan_threads;
+    double pack = config.pack_size * speed.cost_seconds * 2.0; //decoding costs about as much as the evaluation
+    // a path relinking phase walks two paths per guide, each up to n steps of n swap deltas, and
+    // runs pr_ts_iterations Tabu Search from two intermediates of each path, mostly after a rebuild
+    if (config.pr_every > 0) {
+        pack += config.pr_pairs * (2.0 * n * n * speed.delta_seconds + 4.0 * (config.pr_ts_iterations * scan + rebuild)) / config.pr_every;
+    }
+    // the alpha refinement usually replays a few swaps, but count one rebuild to stay on the safe side
+    auto ts_cost = [&]() { return config.ts_iterations * scan + rebuild; };
+    const int min_iterations = 20;
+    // too slow for min_iterations: run Tabu Search less often, then shorter
+    if (!given.count("--ts-every")) {
+        double per_iteration = pack + ts_cost();
+        int every = static_cast<int>(ceil(per_iteration * min_iterations / budget));
+        set("--ts-every", max(1, min(every, 10)));
+    }
+    if (config.ts_iterations > 0 && !given.count("--ts-iterations")) {
+        double per_iteration = pack + ts_cost() / config.ts_every;
+        if (per_iteration * min_iterations > budget) {
+            double affordable = ((budget / min_iterations - pack) * config.ts_every - rebuild) / scan;
+            set("--ts-iterations", static_cast<long long>(clamp_to(affordable, 5, config.ts_iterations)));
+        }
+    }
+    // spend what is left on iterations, capped for tiny instances that converge quickly
+    double per_iteration = pack + ts_cost() / config.ts_every;
+    double iterations = clamp_to(budget / per_iteration, min_iterations, max(100.0, 20.0 * n));
+    // keep two significant digits so small timing noise rarely changes the plan
+    double step = pow(10.0, max(0.0, floor(log10(iterations)) - 1));
+    set("--max-iterations", static_cast<long long>(floor(iterations / step) * step));
+
+    ostringstream summary;
+    summary << fixed << setprecision(1) << "Auto budget " << budget << "s (swap delta " << speed.delta_seconds * 1e9
+            << "ns, cost " << speed.cost_seconds * 1e6 << "us): --pack-size " << config.pack_size
+            << " --max-iterations " << config.max_iterations << " --ts-iterations " << config.ts_iterations
+            << " --tabu-tenure " << config.tabu_tenure << " --ts-every " << config.ts_every;
+    return summary.str();
+}
+
+void apply_preset(Config& config, int n) {
+    if (config.preset.empty()) return;
+    for (const auto& entry : PRESETS) {
+        if (entry.name != config.preset || n > entry.max_n) continue;
+        for (const auto& option : entry.options) {
+            if (!config.pinned.count(option.first)) apply_option(config, option.first, option.second);
+        }
+        return;
+    }
+}
+
+Config parse_arguments(int argc, char* argv[]) {
+    Config config;
+    vector<string> config_files;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
 
         if (arg == "--help" || arg == "-h") {
             print_usage();
             exit(0);
-        } else if (arg == "--input-file" && i + 1 < argc) {
-            config.input_file = argv[++i];
-            } else if (arg == "--pack-size" && i + 1 < argc) {
-                config.pack_size = stoi(argv[++i]);
-                if (config.pack_size < 3) {
-                    throw invalid_argument("Pack size must be at least 3 (needed for alpha/beta/delta)");
-                }
-        } else if (arg == "--max-iterations" && i + 1 < argc) {
-            config.max_iterations = stoi(argv[++i]);
-            if (config.max_iterations < 1) {
-                throw invalid_argument("Max iterations must be positive");
-            }
-        } else if (arg == "--ts-iterations" && i + 1 < argc) {
-            config.ts_iterations = stoi(argv[++i]);
-            if (config.ts_iterations < 0) {
-                throw invalid_argument("TS iterations must be >= 0 (use 0 to disable Tabu Search)");
-            }
-        } else if (arg == "--tabu-tenure" && i + 1 < argc) {
-            config.tabu_tenure = stoi(argv[++i]);
-            if (config.tabu_tenure < 1) {
-                throw invalid_argument("Tabu tenure must be positive");
-            }
-        } else if (arg == "--ts-every" && i + 1 < argc) {
-            config.ts_every = stoi(argv[++i]);
-            if (config.ts_every < 1) {
-                throw invalid_argument("ts-every must be >= 1");
-            }
-        } else if (arg == "--jitter" && i + 1 < argc) {
-            config.jitter = stod(argv[++i]);
-            if (config.jitter < 0.0) {
-                throw invalid_argument("jitter must be >= 0");
+        } else if (arg == "--serve" && i + 1 < argc) {
+            config.serve_socket = argv[++i];
+        } else if (arg == "--client" && i + 1 < argc) {
+            config.client_socket = argv[++i];
+        } else if (arg == "--batch" && i + 1 < argc) {
+            config.batch_file = argv[++i];
+        } else if (arg == "--cache-size" && i + 1 < argc) {
+            config.cache_size = stoi(argv[++i]);
+            if (config.cache_size < 1) {
+                throw invalid_argument("cache-size must be positive");
+            }
+        } else if (arg == "--shutdown") {
+            config.shutdown_server = true;
+        } else if (arg == "--workers" && i + 1 < argc) {
+            config.workers = stoi(argv[++i]);
+            if (config.workers < 1) {
+                throw invalid_argument("workers must be positive");
+            }
+        } else if (arg == "--slice-ms" && i + 1 < argc) {
+            config.slice_ms = stod(argv[++i]);
+            if (config.slice_ms < 0.0) {
+                throw invalid_argument("slice-ms must be >= 0");
             }
+        } else if (arg == "--auto") {
+            apply_option(config, arg, "1");
+            config.explicit_options.push_back({arg, "1"});
+        } else if (arg == "--config" && i + 1 < argc) {
+            config_files.push_back(argv[++i]);
+        } else if (i + 1 < argc && apply_option(config, arg, argv[i + 1])) {
+            // remember what was given explicitly, e.g. so the client can forward it to a server
+            config.explicit_options.push_back({arg, argv[++i]});
         } else {
             cerr << "Unknown argument: " << arg << endl;
             print_usage();
             exit(1);
         }
     }
+    // config files are read last so that command line options override them wherever they appear
+    for (const auto& path : config_files) load_config_file(config, path);
 
     return config;
 }
@@ -378,5 +4081,41 @@ void print_usage() { //implementation of the function that prints usage options
     cout << "  --tabu-tenure N       Tabu list size (default: 10)\n";
     cout << "  --ts-every K          Apply Tabu Search every K iterations (default: 1)\n";
     cout << "  --jitter x            Add uniform jitter in [-x,x] before decoding (default: 0.0)\n";
+    cout << "  --elite-size N        Distinct solutions kept in the elite archive (default: 0 = disabled)\n";
+    cout << "  --elite-distance D    Solutions differing in fewer than D facilities share a slot (default: 3)\n";
+    cout << "  --polish MODE         Swap descent with don't-look bits on every decoded wolf: off, first or best (default: off)\n";
+    cout << "  --polish-looks K      Stop polishing a wolf after K scans per facility (default: 0 = at the local optimum)\n";
+    cout << "  --opposition K        Opposition-based initialization, plus quasi-opposition jumps after K iterations without improvement (default: 0 = off)\n";
+    cout << "  --a-schedule S        Decrease of the GWO coefficient a from 2 to 0: linear or quadratic (default: linear)\n";
+    cout << "  --coefficients C      Source of the r1/r2 coefficients: uniform, logistic or tent (default: uniform)\n";
+    cout << "  --steps S             gwo: plain position update; levy: add Levy flight steps relative to alpha (default: gwo)\n";
+    cout << "  --target COST         Stop the search as soon as a layout costing at most COST is found (default: none)\n";
+    cout << "  --learning MODE       lamarckian: write refined layouts back into wolf positions; baldwinian: only their cost (default: baldwinian)\n";
+    cout << "  --elite-restart K     Restart Tabu Search from an elite solution every K stagnant iterations, needs --elite-size (default: 0 = never)\n";
+    cout << "  --top-k K             Print the K best distinct layouts found during the run (default: 0 = off)\n";
+    cout << "  --pr-every K          Path relinking between alpha and elite solutions every K iterations, needs --elite-size (default: 0 = off)\n";
+    cout << "  --pr-pairs N          Elite solutions relinked with alpha per phase (default: 2)\n";
+    cout << "  --pr-ts-iterations N  Tabu Search iterations from each relinking intermediate (default: 20)\n";
+    cout << "  --solution-tabu K     Tabu Search may not return to any of its last K solutions, by zobrist hash (default: 0 = off)\n";
+    cout << "  --freq-penalty W      Frequency penalty weight while Tabu Search diversifies (default: 0 = off)\n";
+    cout << "  --seed S              Random seed for reproducible runs (default: 0 = random)\n";
+    cout << "  --threads N           Threads used inside one search; results do not depend on N (default: 1)\n";
+    cout << "  --time-limit SEC      Stop the search after SEC seconds (default: 0 = no limit)\n";
+    cout << "  --exact-max-n N       Solve instances up to n = N exactly: enumeration up to 9, then branch and bound (default: 10, 0 = off)\n";
+    cout << "  --exact-nodes N       Branch-and-bound nodes before falling back to GWO + Tabu Search (default: 300000)\n";
+    cout << "  --clusters K|auto     Solve K location clusters separately, then stitch and refine with Tabu Search (default: 0 = off)\n";
+    cout << "  --multilevel N        Coarsen instances larger than N facilities, solve, then refine level by level (default: 0 = off)\n";
+    cout << "  --deadline SEC        Answer within SEC seconds of the request; server and batch report misses (default: 0 = none)\n";
+    cout << "  --priority P          Server and batch: solves with higher P are scheduled first (default: 0)\n";
+    cout << "  --auto                Size pack, iterations and Tabu Search from n, density and the time limit\n";
+    cout << "  --preset NAME         Parameter set chosen by instance size: fast, balanced, thorough or large-n\n";
+    cout << "  --config FILE         Read options from FILE (key = value lines or a JSON object); the command line wins\n";
+    cout << "  --serve SOCKET        Run as a solve server on a unix domain socket\n";
+    cout << "  --batch FILE          Solve every request line of FILE (options as on the command line)\n";
+    cout << "  --workers N           Worker threads in server and batch mode (default: 4)\n";
+    cout << "  --slice-ms MS         Server: a solve yields its worker after MS milliseconds of work (default: 5)\n";
+    cout << "  --cache-size N        Instances kept by the server / batch cache (default: 64)\n";
+    cout << "  --client SOCKET       Send --input-file and the other options to a server and print its answers\n";
+    cout << "  --shutdown            With --client: ask the server to exit\n";
     cout << "  --help, -h            Show this help message\n";
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+// Times evaluate_batch against calculate_cost in a loop on random dense instances, one core.
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -pthread -o bench_batch_eval tests/bench_batch_eval.cpp && ./bench_batch_eval
+#define main qap_solver_main
+#include "../qap_solver.cpp"
+#undef main
+
+// Wall time of f in milliseconds
+template <typename F>
+double time_ms(F f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    mt19937 rng(1);
+    printf("%6s %10s %12s %12s %8s\n", "n", "layouts", "loop ms", "batch ms", "speedup");
+    for (int n : {12, 20, 50, 100, 200, 500, 1000}) {
+        Matrix distance(n, vector<int>(n)), flow(n, vector<int>(n));
+        for (auto& row : distance) for (int& x : row) x = rng() % 100 + 1;
+        for (auto& row : flow) for (int& x : row) x = rng() % 100 + 1;
+        Problem problem = make_problem(distance, flow);
+        // about 2e7 multiply-adds per pass at every size
+        int count = max(32, 20000000 / (n * n));
+        vector<vector<int>> layouts(count, vector<int>(n));
+        for (auto& layout : layouts) {
+            iota(layout.begin(), layout.end(), 0);
+            shuffle(layout.begin(), layout.end(), rng);
+        }
+        vector<long long> loop_costs(count), batch_costs;
+        // the two are timed alternately and the best of 25 rounds kept, so load spikes hit both
+        double loop = 1e300, batch = 1e300;
+        for (int round = 0; round < 25; round++) {
+            loop = min(loop, time_ms([&] {
+                for (int k = 0; k < count; k++) loop_costs[k] = calculate_cost(problem, layouts[k]);
+            }));
+            batch = min(batch, time_ms([&] { evaluate_batch(problem, layouts, batch_costs); }));
+        }
+        if (batch_costs != loop_costs) {
+            printf("n=%d: evaluate_batch and calculate_cost disagree\n", n);
+            return 1;
+        }
+        printf("%6d %10d %12.2f %12.2f %7.2fx\n", n, count, loop, batch, loop / batch);
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+#!/usr/bin/env bash
+# Builds qap_solver into a temporary directory and runs the regression checks.
+# Usage: tests/run_tests.sh   (from anywhere; exits non-zero when a check fails)
+set -u
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+SOLVER="$WORK/qap_solver"
+FAILED=0
+
+g++ -std=c++17 -O2 -pthread -o "$SOLVER" "$ROOT/qap_solver.cpp" || exit 1
+
+pass() { echo "PASS: $1"; }
+fail() { echo "FAIL: $1"; FAILED=1; }
+
+# Recomputes sum flow[i][j] * distance[p[i]][p[j]] for the assignment in a solver report.
+# The instance file holds n, the distance matrix and then the flow matrix.
+recompute_cost() {
+    local instance="$1" report="$2"
+    awk '
+        FNR == NR {
+            for (k = 1; k <= NF; k++) values[count++] = $k
+            next
+        }
+        /Facility [0-9]+ -> Location [0-9]+/ { p[$2] = $5 }
+        END {
+            n = values[0]
+            cost = 0
+            for (i = 0; i < n; i++)
+                for (j = 0; j < n; j++)
+                    cost += values[1 + n * n + i * n + j] * values[1 + p[i] * n + p[j]]
+            printf "%.0f\n", cost
+        }' "$instance" "$report"
+}
+
+# The reported best cost must match a full recomputation of the reported layout.
+check_reported_cost() {
+    local name="$1" instance="$2"
+    shift 2
+    local report="$WORK/$name.out"
+    if ! "$SOLVER" --input-file "$instance" "$@" > "$report" 2>&1; then
+        fail "$name (solver exited with an error)"
+        return
+    fi
+    local reported expected
+    reported="$(sed -n 's/^Best cost found: //p' "$report")"
+    expected="$(recompute_cost "$instance" "$report")"
+    if [ -n "$reported" ] && [ "$reported" = "$expected" ]; then
+        pass "$name"
+    else
+        fail "$name (reported '$reported', recomputed '$expected')"
+    fi
+}
+
+# Distances near 2e9 overflow int when several entries are added before widening.
+LARGE="$ROOT/tests/large_entries_12.txt"
+check_reported_cost large_entries_search "$LARGE" --exact-max-n 0 --seed 1
+check_reported_cost large_entries_default "$LARGE" --seed 1
+check_reported_cost large_entries_exact "$LARGE" --exact-max-n 12 --seed 1
+check_reported_cost large_entries_clusters "$LARGE" --clusters 2 --seed 1
+
+# Asymmetric entries of both signs near 2e9 overflow int in a single difference.
+NEGATIVE="$ROOT/tests/negative_entries_12.txt"
+check_reported_cost negative_entries_search "$NEGATIVE" --exact-max-n 0 --seed 1
+check_reported_cost negative_entries_exact "$NEGATIVE" --exact-max-n 12 --seed 1
+check_reported_cost negative_entries_clusters "$NEGATIVE" --clusters 2 --seed 1
+
+# A 3x4 grid building: its distance matrix has three symmetries (both mirrors and the half
+# turn), which branch and bound prunes. 560 is the optimum found by enumerating all 12! layouts.
+GRID="$ROOT/tests/grid_3x4_12.txt"
+GRID_OPTIMUM=560
+# Passes when the reported cost equals the expected cost and a recomputation of the reported layout.
+check_optimum() {
+    local name="$1" expected="$2" instance="$3"
+    shift 3
+    local report="$WORK/$name.out"
+    if ! "$SOLVER" --input-file "$instance" "$@" > "$report" 2>&1; then
+        fail "$name (solver exited with an error)"
+        return
+    fi
+    local reported recomputed
+    reported="$(sed -n 's/^Best cost found: //p' "$report")"
+    recomputed="$(recompute_cost "$instance" "$report")"
+    if [ "$reported" = "$expected" ] && [ "$recomputed" = "$expected" ]; then
+        pass "$name"
+    else
+        fail "$name (reported '$reported', recomputed '$recomputed', expected $expected)"
+    fi
+}
+check_optimum grid_exact "$GRID_OPTIMUM" "$GRID" --exact-max-n 12 --seed 1
+grep -q '^Distance symmetries: 3 ' "$WORK/grid_exact.out" || fail "grid_exact (grid symmetries not detected)"
+grep -q '^Proven optimal by branch and bound' "$WORK/grid_exact.out" || fail "grid_exact (not solved by branch and bound)"
+check_optimum grid_search "$GRID_OPTIMUM" "$GRID" --exact-max-n 0 --seed 1
+
+# JSON config files may give switches as true/false as well as 1/0.
+# Passes when a run with the given JSON config does (yes) or does not (no) print an auto budget.
+check_config_auto() {
+    local name="$1" json="$2" expected="$3"
+    echo "$json" > "$WORK/$name.json"
+    if ! "$SOLVER" --input-file "$ROOT/instances/meta_massive_50.txt" --config "$WORK/$name.json" > "$WORK/$name.out" 2>&1; then
+        fail "$name ($(tail -n 1 "$WORK/$name.out"))"
+        return
+    fi
+    local applied=no
+    grep -q '^Auto budget' "$WORK/$name.out" && applied=yes
+    if [ "$applied" = "$expected" ]; then pass "$name"; else fail "$name (auto budget applied: $applied)"; fi
+}
+check_config_auto config_json_true '{"auto": true, "seed": 1, "max_iterations": 2}' yes
+check_config_auto config_json_false '{"auto": false, "seed": 1, "max_iterations": 2}' no
+
+# Server round trip: malformed requests get an error reply, then a solve through --client
+# returns the layout and cost a direct run proves optimal.
+SOCKET="$WORK/server.sock"
+"$SOLVER" --serve "$SOCKET" --workers 2 > "$WORK/server.out" 2>&1 &
+SERVER=$!
+for _ in $(seq 50); do [ -S "$SOCKET" ] && break; sleep 0.1; done
+
+# Sends one raw request frame to the server and prints the first reply frame.
+server_reply() {
+    python3 - "$SOCKET" "$1" <<'PY'
+import socket, struct, sys
+s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+s.settimeout(10)
+s.connect(sys.argv[1])
+payload = sys.argv[2].encode()
+s.sendall(struct.pack(">I", len(payload)) + payload)
+def read(count):
+    data = b""
+    while len(data) < count:
+        chunk = s.recv(count - len(data))
+        if not chunk:
+            break
+        data += chunk
+    return data
+size = struct.unpack(">I", read(4))[0]
+print(read(size).decode())
+PY
+}
+
+# Passes when the reply to a raw request is an error event containing the given text.
+check_error_reply() {
+    local name="$1" request="$2" expected="$3"
+    if ! command -v python3 > /dev/null; then
+        echo "SKIP: $name (python3 not found)"
+        return
+    fi
+    local reply
+    reply="$(server_reply "$request")"
+    case "$reply" in
+        *'"event":"error"'*"$expected"*) pass "$name" ;;
+        *) fail "$name (reply '$reply')" ;;
+    esac
+}
+
+check_error_reply server_malformed_request '{"instance": "4\n0 1' Malformed
+# a header announcing a huge n must fail on the missing entries, not allocate n*n first
+check_error_reply server_oversized_header '{"instance":"30000"}' "Invalid instance"
+check_error_reply server_huge_header '{"instance":"2000000000"}' "Invalid instance"
+
+SMALL="$ROOT/instances/silicon_spire_8.txt"
+"$SOLVER" --client "$SOCKET" --input-file "$SMALL" --seed 1 > "$WORK/client.out" 2>&1
+direct="$("$SOLVER" --input-file "$SMALL" --seed 1 | sed -n 's/^Best cost found: //p')"
+served="$(sed -n 's/^Best cost found: //p' "$WORK/client.out")"
+if [ -n "$served" ] && [ "$served" = "$direct" ] && [ "$served" = "$(recompute_cost "$SMALL" "$WORK/client.out")" ]; then
+    pass server_round_trip
+else
+    fail "server_round_trip (served '$served', direct '$direct')"
+fi
+
+# Tabu Search runs far longer than a 5 ms slice, so the served search pauses inside Tabu Search and
+# path relinking many times; it must still find exactly the layout of an uninterrupted run.
+RESUMED=(--input-file "$ROOT/instances/meta_massive_50.txt" --seed 3 --max-iterations 5 --ts-iterations 3000 --elite-size 5 --pr-every 2)
+"$SOLVER" --client "$SOCKET" "${RESUMED[@]}" 2>&1 | grep -E '^Best cost found|^  Facility' > "$WORK/resumed_served.out"
+"$SOLVER" "${RESUMED[@]}" 2>&1 | grep -E '^Best cost found|^  Facility' > "$WORK/resumed_direct.out"
+if [ -s "$WORK/resumed_served.out" ] && cmp -s "$WORK/resumed_served.out" "$WORK/resumed_direct.out"; then
+    pass server_resumed_search
+else
+    fail "server_resumed_search (served and direct layouts differ)"
+fi
+
+"$SOLVER" --client "$SOCKET" --shutdown > /dev/null 2>&1
+wait $SERVER || fail "server_shutdown (server exited with an error)"
+
+exit $FAILED